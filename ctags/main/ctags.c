@@ -224,6 +224,9 @@ static stringList* Excluded = NULL;
 
 static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
 
+/* number of eMalloc (), eCalloc () and eRealloc () calls of each thread */
+static THREAD_LOCAL unsigned long AllocationCount = 0;
+
 #ifdef AMIGA
 # include "ctags.h"
   static const char *VERsion = "$VER: "PROGRAM_NAME" "PROGRAM_VERSION" "
@@ -341,6 +344,8 @@ extern void *eMalloc (const size_t size)
 {
     void *buffer = g_malloc (size);
 
+    AllocationCount++;
+
     if (buffer == NULL)
 	error (FATAL, "out of memory");
 
@@ -351,6 +356,8 @@ extern void *eCalloc (const size_t count, const size_t size)
 {
     void *buffer = calloc (count, size);
 
+    AllocationCount++;
+
     if (buffer == NULL)
 	error (FATAL, "out of memory");
 
@@ -365,12 +372,20 @@ extern void *eRealloc (void *const ptr, const size_t size)
     else
     {
 	buffer = g_realloc (ptr, size);
+	AllocationCount++;
 	if (buffer == NULL)
 	    error (FATAL, "out of memory");
     }
     return buffer;
 }
 
+/* Returns the number of allocations made by the calling thread so far, so that
+ * the allocations of a parse can be counted */
+extern unsigned long getAllocationCount (void)
+{
+    return AllocationCount;
+}
+
 extern void eFree (void *const ptr)
 {
     if (ptr != NULL)
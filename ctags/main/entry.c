@@ -390,13 +390,15 @@ extern void makeTagEntry (const tagEntryInfo *const tag)
 	error (WARNING, "ignoring null tag in %s", vStringValue (File.name));
     else
     {
-	int length = 0;
-
-	if (NULL != TagEntryFunction)
-		length = TagEntryFunction(tag, TagEntryUserData);
-
-	++TagFile.numTags.added;
-	rememberMaxLengths (strlen (tag->name), (size_t) length);
+	/* only count the tags written to a tag file, the parses reporting
+	 * their tags to a callback run in parallel */
+	if (NULL != CurrentParse->tagEntryFunction)
+		CurrentParse->tagEntryFunction(tag, CurrentParse->tagEntryUserData);
+	else
+	{
+		++TagFile.numTags.added;
+		rememberMaxLengths (strlen (tag->name), 0);
+	}
     }
 }
 
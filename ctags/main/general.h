@@ -38,6 +38,21 @@
 # define PRINTF(s,f)
 #endif
 
+/*  State kept between the calls a parser makes while parsing a file is
+ *  declared thread local, so that files can be parsed in several threads
+ *  at once. The initial-exec model avoids a function call on every access
+ *  from a shared library, which is fine as it is not loaded with dlopen().
+ */
+#if defined (__GNUC__) && defined (__ELF__)
+# define THREAD_LOCAL __thread __attribute__ ((tls_model ("initial-exec")))
+#elif defined (__GNUC__)
+# define THREAD_LOCAL __thread
+#elif defined (_MSC_VER)
+# define THREAD_LOCAL __declspec(thread)
+#else
+# define THREAD_LOCAL _Thread_local
+#endif
+
 
 /*  MS-DOS doesn't allow manipulation of standard error, so we send it to
  *  stdout instead.
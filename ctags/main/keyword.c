@@ -22,95 +22,99 @@
 /*
 *   MACROS
 */
-#define HASH_EXPONENT	7	/* must be less than 17 */
+#define MIN_TABLE_SIZE	16	/* must be a power of 2 */
 
 /*
 *   DATA DECLARATIONS
 */
-typedef struct sHashEntry {
-    struct sHashEntry *next;
-    const char *string;
-    langType language;
+typedef struct sKeywordEntry {
+    const char *string;		/* NULL for an empty slot */
+    size_t length;
+    unsigned long hash;
     int value;
-} hashEntry;
+} keywordEntry;
+
+/*  Each language has its own open addressing table, kept at most half full so
+ *  that a lookup usually takes a single probe, and then only compares the
+ *  full hash and length before touching the keyword itself.
+ */
+typedef struct sKeywordTable {
+    keywordEntry *entries;
+    unsigned int size;		/* a power of 2, or 0 */
+    unsigned int count;
+} keywordTable;
 
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 1 << HASH_EXPONENT;
-static hashEntry **HashTable = NULL;
+static keywordTable *Tables = NULL;
+static int TableUpper = -1;	/* upper language index in list */
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+/*  FNV-1a hash, also computing the string length in the same pass.
+ */
+static unsigned long hashValue (const char *const string, size_t *const length)
 {
-    static boolean allocated = FALSE;
-
-    if (! allocated)
-    {
-	unsigned int i;
-
-	HashTable = xMalloc (TableSize, hashEntry*);
+    unsigned long value = 2166136261UL;
+    const unsigned char *p;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
-	    HashTable [i] = NULL;
+    Assert (string != NULL);
 
-	allocated = TRUE;
+    for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+    {
+	value ^= *p;
+	value = (value * 16777619UL) & 0xffffffffUL;
     }
-    return HashTable;
+    *length = (size_t) (p - (const unsigned char *) string);
+
+    return value;
 }
 
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
+static keywordTable *getKeywordTable (langType language)
 {
-    hashEntry **const table = getHashTable ();
-    hashEntry *entry;
-
-    Assert (hashedValue < TableSize);
-    entry = table [hashedValue];
-
-    return entry;
+    if (language < 0  ||  language > TableUpper)
+	return NULL;
+    return Tables + language;
 }
 
-static unsigned long hashValue (const char *const string)
+static keywordEntry *findSlot (const keywordTable *const table,
+			       const char *const string, size_t length,
+			       unsigned long hash)
 {
-    unsigned long value = 0;
-    const unsigned char *p;
+    const unsigned int mask = table->size - 1;
+    unsigned int i = (unsigned int) hash & mask;
 
-    Assert (string != NULL);
-
-    /*  We combine the various words of the multiword key using the method
-     *  described on page 512 of Vol. 3 of "The Art of Computer Programming".
-     */
-    for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+    while (table->entries [i].string != NULL)
     {
-	value <<= 1;
-	if (value & 0x00000100L)
-	    value = (value & 0x000000ffL) + 1L;
-	value ^= *p;
-    }
-    /*  Algorithm from page 509 of Vol. 3 of "The Art of Computer Programming"
-     *  Treats "value" as a 16-bit integer plus 16-bit fraction.
-     */
-    value *= 40503L;		/* = 2^16 * 0.6180339887 ("golden ratio") */
-    value &= 0x0000ffffL;	/* keep fractional part */
-    value >>= 16 - HASH_EXPONENT; /* scale up by hash size and move down */
+	const keywordEntry *const entry = &table->entries [i];
 
-    return value;
+	if (entry->hash == hash  &&  entry->length == length  &&
+	    memcmp (entry->string, string, length) == 0)
+	    break;
+	i = (i + 1) & mask;
+    }
+    return &table->entries [i];
 }
 
-static hashEntry *newEntry (const char *const string,
-			    langType language, int value)
+static void resizeTable (keywordTable *const table, unsigned int size)
 {
-    hashEntry *const entry = xMalloc (1, hashEntry);
+    keywordTable old = *table;
+    unsigned int i;
 
-    entry->next     = NULL;
-    entry->string   = string;
-    entry->language = language;
-    entry->value    = value;
+    table->entries = xCalloc (size, keywordEntry);
+    table->size = size;
+    for (i = 0  ;  i < old.size  ;  ++i)
+    {
+	const keywordEntry *const entry = &old.entries [i];
 
-    return entry;
+	if (entry->string != NULL)
+	    *findSlot (table, entry->string, entry->length, entry->hash) = *entry;
+    }
+    if (old.entries != NULL)
+	eFree (old.entries);
 }
 
 /*  Note that it is assumed that a "value" of zero means an undefined keyword
@@ -120,133 +124,111 @@ static hashEntry *newEntry (const char *const string,
  */
 extern void addKeyword (const char *const string, langType language, int value)
 {
-    const unsigned long hashedValue = hashValue (string);
-    hashEntry *tableEntry = getHashTableEntry (hashedValue);
-    hashEntry *entry = tableEntry;
+    keywordTable *table;
+    keywordEntry *entry;
+    unsigned long hash;
+    size_t length;
 
 #ifdef TM_DEBUG
     fprintf(stderr, "Adding keyword %s to language %d\n", string, language);
 #endif
-    if (entry == NULL)
-    {
-	hashEntry **const table = getHashTable ();
-	hashEntry *new = newEntry (string, language, value);
-
-	table [hashedValue] = new;
-    }
-    else
+    Assert (language >= 0);
+    if (language > TableUpper)
     {
-	hashEntry *prev = NULL;
+	int i;
 
-	while (entry != NULL)
+	Tables = xRealloc (Tables, (language + 1), keywordTable);
+	for (i = TableUpper + 1  ;  i <= language  ;  ++i)
 	{
-	    if (language == entry->language  &&
-		strcmp (string, entry->string) == 0)
-	    {
-		Assert (("Already in table" == NULL));
-	    }
-	    prev = entry;
-	    entry = entry->next;
+	    Tables [i].entries = NULL;
+	    Tables [i].size = 0;
+	    Tables [i].count = 0;
 	}
-	if (entry == NULL)
-	{
-	    hashEntry *new = newEntry (string, language, value);
+	TableUpper = language;
+    }
+    table = Tables + language;
+    if (2 * (table->count + 1) > table->size)
+	resizeTable (table, table->size == 0 ? MIN_TABLE_SIZE : 2 * table->size);
 
-	    Assert (prev != NULL);
-	    prev->next = new;
-	}
+    hash = hashValue (string, &length);
+    entry = findSlot (table, string, length, hash);
+    if (entry->string != NULL)
+    {
+	Assert (("Already in table" == NULL));
+    }
+    else
+    {
+	entry->string = string;
+	entry->length = length;
+	entry->hash   = hash;
+	entry->value  = value;
+	table->count++;
     }
 }
 
 extern int lookupKeyword (const char *const string, langType language)
 {
-    const unsigned long hashedValue = hashValue (string);
-    hashEntry *entry = getHashTableEntry (hashedValue);
-    int value = -1;
+    const keywordTable *const table = getKeywordTable (language);
+    const keywordEntry *entry;
+    unsigned long hash;
+    size_t length;
 
-    while (entry != NULL)
-    {
-	if (language == entry->language  &&  strcmp (string, entry->string) == 0)
-	{
-	    value = entry->value;
-	    break;
-	}
-	entry = entry->next;
-    }
-    return value;
+    if (table == NULL  ||  table->count == 0)
+	return -1;
+
+    hash = hashValue (string, &length);
+    entry = findSlot (table, string, length, hash);
+
+    return entry->string != NULL ? entry->value : -1;
 }
 
 extern void freeKeywordTable (void)
 {
-    if (HashTable != NULL)
+    if (Tables != NULL)
     {
-	unsigned int i;
+	int i;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (i = 0  ;  i <= TableUpper  ;  ++i)
 	{
-	    hashEntry *entry = HashTable [i];
-
-	    while (entry != NULL)
-	    {
-		hashEntry *next = entry->next;
-		eFree (entry);
-		entry = next;
-	    }
+	    if (Tables [i].entries != NULL)
+		eFree (Tables [i].entries);
 	}
-	eFree (HashTable);
+	eFree (Tables);
+	Tables = NULL;
+	TableUpper = -1;
     }
 }
 
 #ifdef TM_DEBUG
 
-static void printEntry (const hashEntry *const entry)
+extern void printKeywordTable (void)
 {
-    printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
-}
+    int i;
 
-static unsigned int printBucket (const unsigned int i)
-{
-    hashEntry **const table = getHashTable ();
-    hashEntry *entry = table [i];
-    unsigned int measure = 1;
-    boolean first = TRUE;
-
-    printf ("%2d:", i);
-    if (entry == NULL)
-	printf ("\n");
-    else while (entry != NULL)
+    for (i = 0  ;  i <= TableUpper  ;  ++i)
     {
-	if (! first)
-	    printf ("    ");
-	else
+	const keywordTable *const table = Tables + i;
+	unsigned long probes = 0;
+	unsigned int j;
+
+	if (table->count == 0)
+	    continue;
+	printf ("%s: %u keywords in %u slots\n", getLanguageName (i),
+		table->count, table->size);
+	for (j = 0  ;  j < table->size  ;  ++j)
 	{
-	    printf (" ");
-	    first = FALSE;
-	}
-	printEntry (entry);
-	entry = entry->next;
-	measure = 2 * measure;
-    }
-    return measure - 1;
-}
-
-extern void printKeywordTable (void)
-{
-    unsigned long emptyBucketCount = 0;
-    unsigned long measure = 0;
-    unsigned int i;
+	    const keywordEntry *const entry = &table->entries [j];
 
-    for (i = 0  ;  i < TableSize  ;  ++i)
-    {
-	const unsigned int pass = printBucket (i);
+	    if (entry->string != NULL)
+	    {
+		const unsigned int home = (unsigned int) entry->hash & (table->size - 1);
 
-	measure += pass;
-	if (pass == 0)
-	    ++emptyBucketCount;
+		printf ("  %-15s %u\n", entry->string, ((j - home) & (table->size - 1)) + 1);
+		probes += ((j - home) & (table->size - 1)) + 1;
+	    }
+	}
+	printf ("average probes = %.2f\n", (double) probes / table->count);
     }
-
-    printf ("spread measure = %ld\n", measure);
-    printf ("%ld empty buckets\n", emptyBucketCount);
 }
 
 #endif
@@ -64,6 +64,10 @@ enum pType { PTRN_TAG, PTRN_CALLBACK };
 
 typedef struct {
 	GRegex *pattern;
+	/* a string every line matching the pattern contains, or NULL.  It is
+	 * lower-cased if the pattern is caseless */
+	char *literal;
+	boolean caseless;
 	enum pType type;
 	union {
 		struct {
@@ -93,6 +97,9 @@ static boolean regexBroken = FALSE;
 static patternSet* Sets = NULL;
 static int SetUpper = -1;  /* upper language index in list */
 
+/* lower-cased copy of the current line, for caseless literals */
+static THREAD_LOCAL vString* LowerLine = NULL;
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -108,6 +115,11 @@ static void clearPatternSet (const langType language)
 			regexPattern *p = &set->patterns [i];
 			g_regex_unref(p->pattern);
 			p->pattern = NULL;
+			if (p->literal != NULL)
+			{
+				eFree (p->literal);
+				p->literal = NULL;
+			}
 
 			if (p->type == PTRN_TAG)
 			{
@@ -244,6 +256,168 @@ static boolean parseTagRegex (
 	return result;
 }
 
+/* Escapes standing for a single character class or assertion, which can be
+ * skipped without having to parse what follows them */
+static boolean isSimpleEscape (const char c)
+{
+	return (boolean) (c != '\0'  &&  strchr ("dDwWsSbBAzZGnrtfe", c) != NULL);
+}
+
+/* Finds the longest run of literal characters that any match of `regexp'
+ * must contain, so that lines not containing it can be rejected with a plain
+ * string search instead of running the regex engine.  The analysis is
+ * conservative: only characters outside groups count, and constructs it does
+ * not understand make it give up and return NULL.
+ */
+static char* findRequiredLiteral (const char* const regexp)
+{
+	vString* run = vStringNew ();
+	vString* best = vStringNew ();
+	boolean lastIsLiteral = FALSE;
+	boolean unknown = FALSE;
+	int depth = 0;
+	const char* p = regexp;
+	char* result = NULL;
+
+	while (*p != '\0'  &&  ! unknown)
+	{
+		const char c = *p;
+		boolean literal = FALSE;
+
+		if (c == '\\')
+		{
+			if (p [1] == '\0'  ||  (isalnum ((unsigned char) p [1])  &&  ! isSimpleEscape (p [1])))
+				unknown = TRUE;
+			else if (isalnum ((unsigned char) p [1]))
+				p += 2;
+			else
+			{
+				literal = (boolean) (depth == 0);
+				if (literal)
+					vStringPut (run, p [1]);
+				p += 2;
+			}
+		}
+		else if (c == '[')
+		{
+			/* skip the character class */
+			++p;
+			if (*p == '^')
+				++p;
+			if (*p == ']')
+				++p;
+			while (*p != '\0'  &&  *p != ']')
+			{
+				if (*p == '\\'  &&  p [1] != '\0')
+					p += 2;
+				else if (*p == '['  &&  (p [1] == ':'  ||  p [1] == '.'  ||  p [1] == '='))
+				{
+					const char end [3] = { p [1], ']', '\0' };
+					const char* const close = strstr (p + 2, end);
+					if (close == NULL)
+						break;
+					p = close + 2;
+				}
+				else
+					++p;
+			}
+			if (*p != ']')
+				unknown = TRUE;
+			else
+				++p;
+		}
+		else if (c == '(')
+		{
+			if (p [1] == '?'  ||  p [1] == '*')
+				unknown = TRUE;
+			++depth;
+			++p;
+		}
+		else if (c == ')')
+		{
+			--depth;
+			++p;
+		}
+		else if (c == '|')
+		{
+			/* a top-level alternative makes nothing required */
+			if (depth == 0)
+				unknown = TRUE;
+			++p;
+		}
+		else if (c == '*'  ||  c == '?'  ||  c == '{')
+		{
+			const char* q = p + 1;
+			if (c == '{')
+			{
+				while (isdigit ((unsigned char) *q)  ||  *q == ',')
+					++q;
+				if (*q == '}')
+					++q;
+				else
+					q = p + 1;  /* a literal brace */
+			}
+			/* the character before is optional, drop it (all of its bytes) */
+			if (lastIsLiteral)
+			{
+				size_t len = vStringLength (run) - 1;
+				while (len > 0  &&  ((unsigned char) vStringItem (run, len) & 0xC0) == 0x80)
+					--len;
+				vStringTruncate (run, len);
+			}
+			p = q;
+		}
+		else if (c == '+'  ||  c == '.'  ||  c == '^'  ||  c == '$')
+			++p;
+		else
+		{
+			literal = (boolean) (depth == 0);
+			if (literal)
+				vStringPut (run, c);
+			++p;
+		}
+
+		if (! literal)
+		{
+			if (vStringLength (run) > vStringLength (best))
+				vStringCopy (best, run);
+			vStringClear (run);
+		}
+		lastIsLiteral = literal;
+	}
+	if (vStringLength (run) > vStringLength (best))
+		vStringCopy (best, run);
+
+	if (! unknown  &&  depth == 0  &&  vStringLength (best) > 0)
+		result = eStrdup (vStringValue (best));
+	vStringDelete (run);
+	vStringDelete (best);
+	return result;
+}
+
+static void setPatternLiteral (regexPattern* const ptrn)
+{
+	ptrn->caseless = (boolean)
+		((g_regex_get_compile_flags (ptrn->pattern) & G_REGEX_CASELESS) != 0);
+	ptrn->literal = findRequiredLiteral (g_regex_get_pattern (ptrn->pattern));
+	if (ptrn->literal != NULL  &&  ptrn->caseless)
+	{
+		char* c;
+		for (c = ptrn->literal  ;  *c != '\0'  ;  ++c)
+		{
+			/* non-ASCII characters may match caselessly in ways ASCII
+			 * lower-casing can't reproduce */
+			if ((unsigned char) *c >= 0x80)
+			{
+				eFree (ptrn->literal);
+				ptrn->literal = NULL;
+				break;
+			}
+			*c = (char) tolower ((int) *c);
+		}
+	}
+}
+
 static void addCompiledTagPattern (
 		const langType language, GRegex* const pattern,
 		char* const name, const char kind, char* const kindName,
@@ -269,6 +443,7 @@ static void addCompiledTagPattern (
 
 	ptrn->pattern = pattern;
 	ptrn->type    = PTRN_TAG;
+	setPatternLiteral (ptrn);
 	ptrn->u.tag.name_pattern = name;
 	ptrn->u.tag.kind.enabled = TRUE;
 	ptrn->u.tag.kind.letter  = kind;
@@ -300,6 +475,7 @@ static void addCompiledCallbackPattern (
 
 	ptrn->pattern = pattern;
 	ptrn->type    = PTRN_CALLBACK;
+	setPatternLiteral (ptrn);
 	ptrn->u.callback.function = callback;
 }
 
@@ -506,6 +682,25 @@ static boolean matchRegexPattern (const vString* const line,
 	return result;
 }
 
+/* Lower-cases `line' into LowerLine.  Returns NULL if the line contains
+ * non-ASCII characters, in which case caseless literals can't be trusted.
+ */
+static const char* lowerAsciiLine (const vString* const line)
+{
+	const char* c;
+	if (LowerLine == NULL)
+		LowerLine = vStringNew ();
+	vStringClear (LowerLine);
+	for (c = vStringValue (line)  ;  *c != '\0'  ;  ++c)
+	{
+		if ((unsigned char) *c >= 0x80)
+			return NULL;
+		vStringPut (LowerLine, tolower ((int) *c));
+	}
+	vStringTerminate (LowerLine);
+	return vStringValue (LowerLine);
+}
+
 #endif
 
 /* PUBLIC INTERFACE */
@@ -520,10 +715,32 @@ extern boolean matchRegex (const vString* const line, const langType language)
 		Sets [language].count > 0)
 	{
 		const patternSet* const set = Sets + language;
+		const char* lower = NULL;
+		boolean lowered = FALSE;
 		unsigned int i;
 		for (i = 0  ;  i < set->count  ;  ++i)
-			if (matchRegexPattern (line, set->patterns + i))
+		{
+			const regexPattern* const ptrn = set->patterns + i;
+
+			/* skip the regex engine on lines lacking the required literal */
+			if (ptrn->literal != NULL)
+			{
+				const char* haystack = vStringValue (line);
+				if (ptrn->caseless)
+				{
+					if (! lowered)
+					{
+						lower = lowerAsciiLine (line);
+						lowered = TRUE;
+					}
+					haystack = lower;
+				}
+				if (haystack != NULL  &&  strstr (haystack, ptrn->literal) == NULL)
+					continue;
+			}
+			if (matchRegexPattern (line, ptrn))
 				result = TRUE;
+		}
 	}
 	return result;
 }
@@ -684,6 +901,19 @@ extern void freeRegexResources (void)
 		eFree (Sets);
 	Sets = NULL;
 	SetUpper = -1;
+#endif
+	freeRegexParseResources ();
+}
+
+/* Frees what a parse left in the thread local state, as the thread may exit
+ * afterwards.
+ */
+extern void freeRegexParseResources (void)
+{
+#ifdef HAVE_REGEX
+	if (LowerLine != NULL)
+		vStringDelete (LowerLine);
+	LowerLine = NULL;
 #endif
 }
 
@@ -649,6 +649,41 @@ int mio_printf (MIO *mio, const char *format, ...)
 	return rv;
 }
 
+/**
+ * mio_memory_peek:
+ * @mio: A #MIO object
+ * @size: Return location for the number of bytes available
+ *
+ * Gets the data left to read in a memory #MIO stream without consuming it, so
+ * it can be scanned a block at a time rather than with mio_getc(). The data
+ * can then be consumed with mio_memory_skip().
+ *
+ * Returns: A pointer to the data left to read, or %NULL if @mio is not a memory
+ * stream, a character was put back or there is no data left.
+ */
+const unsigned char *mio_memory_peek (MIO *mio, size_t *size)
+{
+	if (mio->type != MIO_TYPE_MEMORY ||
+		mio->impl.mem.ungetch != EOF ||
+		mio->impl.mem.pos >= mio->impl.mem.size)
+		return NULL;
+
+	*size = mio->impl.mem.size - mio->impl.mem.pos;
+	return mio->impl.mem.buf + mio->impl.mem.pos;
+}
+
+/**
+ * mio_memory_skip:
+ * @mio: A memory #MIO object
+ * @size: Number of bytes to skip, at most what mio_memory_peek() returned
+ *
+ * Consumes data returned by mio_memory_peek().
+ */
+void mio_memory_skip (MIO *mio, size_t size)
+{
+	mio->impl.mem.pos += size;
+}
+
 /**
  * mio_getc:
  * @mio: A #MIO object
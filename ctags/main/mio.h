@@ -157,6 +157,8 @@ size_t mio_write (MIO *mio,
 				  size_t size,
 				  size_t nmemb);
 int mio_getc (MIO *mio);
+const unsigned char *mio_memory_peek (MIO *mio, size_t *size);
+void mio_memory_skip (MIO *mio, size_t size);
 char *mio_gets (MIO *mio, char *s, size_t size);
 int mio_ungetc (MIO *mio, int ch);
 int mio_putc (MIO *mio, int c);
@@ -23,6 +23,7 @@
 #define OPTION_WRITE
 #include "options.h"
 #include "parse.h"
+#include "read.h"
 
 #include <glib.h>
 
@@ -150,44 +151,38 @@ extern boolean isIncludeFile (const char *const fileName)
     return FALSE;
 }
 
-/* tags_ignore is a NULL-terminated array of strings, read from ~/.config/geany/ignore.tags.
- * This file contains a space or newline separated list of symbols which should be ignored
- * by the C/C++ parser, see -I command line option of ctags for details. */
-gchar **c_tags_ignore = NULL;
-
-/*  Determines whether or not "name" should be ignored, per the ignore list.
+/*  Determines whether or not "name" should be ignored, per the ignore list
+ *  of the current parse. Geany reads it from ~/.config/geany/ignore.tags, a
+ *  space or newline separated list of symbols which should be ignored by the
+ *  C/C++ parser, see -I command line option of ctags for details.
  */
 extern boolean isIgnoreToken (const char *const name,
 			      boolean *const pIgnoreParens,
 			      const char **const replacement)
 {
+	char **const ignoreTokens = CurrentParse->ignoreTokens;
 	boolean result = FALSE;
 
-	if (c_tags_ignore != NULL)
+	if (ignoreTokens != NULL)
 	{
 		const size_t nameLen = strlen (name);
 		unsigned int i;
-		guint len = g_strv_length (c_tags_ignore);
-		vString *token = vStringNew();
 
 		if (pIgnoreParens != NULL)
 			*pIgnoreParens = FALSE;
 
-		for (i = 0  ;  i < len ;  ++i)
+		for (i = 0  ;  ignoreTokens[i] != NULL  ;  ++i)
 		{
-			size_t tokenLen;
-
-			vStringCopyS (token, c_tags_ignore[i]);
-			vStringTerminate (token);
-			tokenLen = vStringLength (token);
+			const char *const token = ignoreTokens[i];
+			const size_t tokenLen = strlen (token);
 
-			if (tokenLen >= 2 && vStringChar (token, tokenLen - 1) == '*' &&
-				strncmp (vStringValue (token), name, tokenLen - 1) == 0)
+			if (tokenLen >= 2 && token[tokenLen - 1] == '*' &&
+				strncmp (token, name, tokenLen - 1) == 0)
 			{
 				result = TRUE;
 				break;
 			}
-			if (strncmp (vStringValue (token), name, nameLen) == 0)
+			if (strncmp (token, name, nameLen) == 0)
 			{
 				if (nameLen == tokenLen)
 				{
@@ -195,22 +190,21 @@ extern boolean isIgnoreToken (const char *const name,
 					break;
 				}
 				else if (tokenLen == nameLen + 1  &&
-						vStringChar (token, tokenLen - 1) == '+')
+						token[tokenLen - 1] == '+')
 				{
 					result = TRUE;
 					if (pIgnoreParens != NULL)
 						*pIgnoreParens = TRUE;
 					break;
 				}
-				else if (vStringChar (token, nameLen) == '=')
+				else if (token[nameLen] == '=')
 				{
 					if (replacement != NULL)
-						*replacement = vStringValue (token) + nameLen + 1;
+						*replacement = token + nameLen + 1;
 					break;
 				}
 			}
 		}
-		vStringDelete (token);
 	}
 	return result;
 }
@@ -32,20 +32,11 @@
 static parserDefinitionFunc* BuiltInParsers[] = { PARSER_LIST };
 parserDefinition** LanguageTable = NULL;
 unsigned int LanguageCount = 0;
-tagEntryFunction TagEntryFunction = NULL;
-void *TagEntryUserData = NULL;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-extern void setTagEntryFunction(tagEntryFunction entry_function, void *user_data)
-{
-    TagEntryFunction = entry_function;
-    TagEntryUserData = user_data;
-}
-
-
 extern void makeSimpleTag (const vString* const name,
 			   kindOption* const kinds, const int kind)
 {
@@ -640,6 +631,7 @@ static boolean createTagsWithFallback (const char *const fileName,
 extern boolean parseFile (const char *const fileName)
 {
     boolean tagFileResized = FALSE;
+    parseContext context;
     langType language = Option.language;
     if (Option.language == LANG_AUTO)
 	language = getFileLanguage (fileName);
@@ -647,7 +639,9 @@ extern boolean parseFile (const char *const fileName)
 	if (Option.filter)
 	    openTagFile ();
 
+	beginParse (&context, NULL, NULL);
 	tagFileResized = createTagsWithFallback (fileName, language);
+	endParse ();
 
 	addTotals (1, 0L, 0L);
 
@@ -124,14 +124,10 @@ extern void disableRegexKinds (const langType UNUSED language);
 extern boolean enableRegexKind (const langType language, const int kind, const boolean mode);
 extern void printRegexKindOptions (const langType language);
 extern void freeRegexResources (void);
+extern void freeRegexParseResources (void);
 extern void checkRegex (void);
 
 
-/* Extra stuff for Tag Manager */
-extern tagEntryFunction TagEntryFunction;
-extern void *TagEntryUserData;
-extern void setTagEntryFunction(tagEntryFunction entry_function, void *user_data);
-
 #endif	/* _PARSE_H */
 
 /* vi:set tabstop=8 shiftwidth=4: */
@@ -23,13 +23,14 @@
 #include "entry.h"
 #include "main.h"
 #include "options.h"
+#include "parse.h"
 
 /*
 *   DATA DEFINITIONS
 */
-inputFile File;			/* globally read through macros */
-static MIOPos StartOfLine;	/* holds deferred position of start of line */
+THREAD_LOCAL parseContext *CurrentParse = NULL;	/* globally read through macros */
 
+#define StartOfLine (CurrentParse->startOfLine)
 
 
 /* Read a character choosing automatically between file or buffer, depending
@@ -46,12 +47,40 @@ static MIOPos StartOfLine;	/* holds deferred position of start of line */
 *   FUNCTION DEFINITIONS
 */
 
+/*  Makes `context' the context of the parses done by this thread until
+ *  endParse() is called.
+ */
+extern void beginParse (parseContext *const context,
+			tagEntryFunction entry_function, void *user_data)
+{
+    Assert (CurrentParse == NULL);
+    memset (context, 0, sizeof (parseContext));
+    context->tagEntryFunction = entry_function;
+    context->tagEntryUserData = user_data;
+    CurrentParse = context;
+}
+
+extern void endParse (void)
+{
+    freeSourceFileResources ();
+    freeRegexParseResources ();
+    CurrentParse = NULL;
+}
+
 extern void freeSourceFileResources (void)
 {
+    if (CurrentParse == NULL)
+	return;
+
     vStringDelete (File.name);
     vStringDelete (File.path);
     vStringDelete (File.source.name);
     vStringDelete (File.line);
+    if (File.source.tagPath != NULL)
+	eFree (File.source.tagPath);
+    if (File.mio != NULL)
+	mio_free (File.mio);
+    memset (&File, 0, sizeof (inputFile));
 }
 
 /*
@@ -92,9 +121,6 @@ static void setSourceFileParameters (vString *const fileName, const langType lan
 	File.source.tagPath =
 		relativeFilename (vStringValue (fileName), TagFile.directory);
 
-    if (vStringLength (fileName) > TagFile.max.file)
-	TagFile.max.file = vStringLength (fileName);
-
     File.source.isHeader = isIncludeFile (vStringValue (fileName));
     if (language != -1)
 		File.source.language = language;
@@ -436,6 +462,57 @@ extern void fileUngetc (int c)
 	File.ungetchBuf[File.ungetchIdx++] = c;
 }
 
+/*  Reads a whole line at once from the data of a memory stream, doing the
+ *  same processing as reading it with iFileGetc (). Returns FALSE if the line
+ *  has to be read character by character.
+ */
+static boolean iFileGetLineFromMemory (void)
+{
+    const unsigned char *data, *end, *cr;
+    size_t length, lineLength, consumed;
+
+    /*	line directives are handled in iFileGetc ()
+     */
+    if (! File.newLine  ||  Option.lineDirectives)
+	return FALSE;
+    data = mio_memory_peek (File.mio, &length);
+    if (data == NULL)
+	return FALSE;
+
+    end = memchr (data, NEWLINE, length);
+    lineLength = (end != NULL) ? (size_t) (end - data) : length;
+    cr = memchr (data, CRETURN, lineLength);
+    if (cr != NULL)
+    {
+	end = cr;
+	lineLength = (size_t) (cr - data);
+    }
+    /*	null characters are dropped by vStringPut (), let iFileGetc () do it
+     */
+    if (memchr (data, '\0', lineLength) != NULL)
+	return FALSE;
+
+    fileNewline ();
+    vStringNCatSUnsafe (File.line, (const char *) data, lineLength);
+    consumed = lineLength;
+    if (end == NULL)
+	File.eof = TRUE;
+    else
+    {
+	/*  canonicalize CR, LF and CR-LF into a newline like iFileGetc ()
+	 */
+	consumed++;
+	if (*end == CRETURN  &&  consumed < length  &&  data [consumed] == NEWLINE)
+	    consumed++;
+	vStringPut (File.line, NEWLINE);
+	File.newLine = TRUE;
+    }
+    mio_memory_skip (File.mio, consumed);
+    if (File.newLine)
+	mio_getpos (File.mio, &StartOfLine);
+    return TRUE;
+}
+
 static vString *iFileGetLine (void)
 {
     vString *result = NULL;
@@ -443,6 +520,14 @@ static vString *iFileGetLine (void)
     if (File.line == NULL)
 	File.line = vStringNew ();
     vStringClear (File.line);
+    if (iFileGetLineFromMemory ())
+    {
+	vStringTerminate (File.line);
+#ifdef HAVE_REGEX
+	matchRegex (File.line, File.source.language);
+#endif
+	return File.line;
+    }
     do
     {
 	c = iFileGetc ();
@@ -88,15 +88,32 @@ typedef struct sInputFile {
     } source;
 } inputFile;
 
+/*  Everything a single parse reads and writes outside of the parsers' own
+ *  state. Each thread parses through its own context, see beginParse().
+ */
+typedef struct sParseContext {
+    inputFile file;		/* the input being parsed */
+    MIOPos startOfLine;		/* holds deferred position of start of line */
+    tagEntryFunction tagEntryFunction;	/* receives the tags found */
+    void *tagEntryUserData;
+    char **ignoreTokens;	/* NULL terminated, see isIgnoreToken () */
+} parseContext;
+
 /*
 *   GLOBAL VARIABLES
 */
-/* should not be modified externally */
-extern inputFile File;
+/* the context of the parse running in this thread, should not be modified
+ * externally */
+extern THREAD_LOCAL parseContext *CurrentParse;
+
+#define File (CurrentParse->file)
 
 /*
 *   FUNCTION PROTOTYPES
 */
+extern void beginParse (parseContext *const context,
+			tagEntryFunction entry_function, void *user_data);
+extern void endParse (void);
 extern void freeSourceFileResources (void);
 extern boolean fileOpen (const char *const fileName, const langType language);
 extern boolean fileEOF (void);
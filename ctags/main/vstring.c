@@ -136,16 +136,22 @@ extern vString *vStringNewInit (const char *const s)
 extern void vStringNCatS (
 		vString *const string, const char *const s, const size_t length)
 {
-    const char *p = s;
-    size_t remain = length;
+    const char *const end = memchr (s, '\0', length);
 
-    while (*p != '\0'  &&  remain > 0)
-    {
-	vStringPut (string, *p);
-	--remain;
-	++p;
-    }
-    vStringTerminate (string);
+    vStringNCatSUnsafe (string, s, end != NULL ? (size_t) (end - s) : length);
+}
+
+/*  Like vStringNCatS (), but copies the whole block at once. The first length
+ *  bytes of s must not contain any null character.
+ */
+extern void vStringNCatSUnsafe (
+		vString *const string, const char *const s, const size_t length)
+{
+    while (string->length + length + 1 > string->size)
+	vStringAutoResize (string);
+    memcpy (string->buffer + string->length, s, length);
+    string->length += length;
+    string->buffer [string->length] = '\0';
 }
 
 /*  Strip trailing newline from string.
@@ -260,7 +260,7 @@ typedef struct sParenInfo
 *   DATA DEFINITIONS
 */
 
-static jmp_buf Exception;
+static THREAD_LOCAL jmp_buf Exception;
 
 static langType Lang_c;
 static langType Lang_cpp;
@@ -646,10 +646,60 @@ static void retardToken (statementInfo *const st)
 	setToken(st, TOKEN_NONE);
 }
 
+/*
+*   Object pools
+*
+*   Tokens, statements and scratch strings are recycled rather than freed,
+*   and only released once the file is parsed.
+*/
+typedef struct sObjectPool {
+	void **items;
+	unsigned int count;
+	unsigned int size;
+} objectPool;
+
+static THREAD_LOCAL objectPool TokenPool = { NULL, 0, 0 };
+static THREAD_LOCAL objectPool StringPool = { NULL, 0, 0 };
+static THREAD_LOCAL statementInfo *StatementPool = NULL;	/* linked through parent */
+static THREAD_LOCAL vString *VarType = NULL;	/* returned by getVarType() */
+
+static void *poolTake (objectPool *const pool)
+{
+	return pool->count > 0 ? pool->items [--pool->count] : NULL;
+}
+
+static void poolGive (objectPool *const pool, void *const item)
+{
+	if (pool->count == pool->size)
+	{
+		pool->size = pool->size == 0 ? 16 : 2 * pool->size;
+		pool->items = xRealloc (pool->items, pool->size, void*);
+	}
+	pool->items [pool->count++] = item;
+}
+
+static vString *newString (void)
+{
+	vString *const string = poolTake (&StringPool);
+	if (string == NULL)
+		return vStringNew ();
+	vStringClear (string);
+	return string;
+}
+
+static void deleteString (vString *const string)
+{
+	poolGive (&StringPool, string);
+}
+
 static tokenInfo *newToken (void)
 {
-	tokenInfo *const token = xMalloc (1, tokenInfo);
-	token->name = vStringNew();
+	tokenInfo *token = poolTake (&TokenPool);
+	if (token == NULL)
+	{
+		token = xMalloc (1, tokenInfo);
+		token->name = vStringNew();
+	}
 	initToken(token);
 	return token;
 }
@@ -657,10 +707,13 @@ static tokenInfo *newToken (void)
 static void deleteToken (tokenInfo *const token)
 {
 	if (token != NULL)
-	{
-		vStringDelete(token->name);
-		eFree(token);
-	}
+		poolGive (&TokenPool, token);
+}
+
+static void destroyToken (tokenInfo *const token)
+{
+	vStringDelete(token->name);
+	eFree(token);
 }
 
 static const char *accessString (const accessType laccess)
@@ -1264,7 +1317,6 @@ static void addOtherFields (tagEntryInfo* const tag, const tagType type,
 static const char *getVarType (const statementInfo *const st,
 							   const tokenInfo *const nameToken)
 {
-	static vString *vt = NULL;
 	unsigned int i;
 	unsigned int end = st->tokenIndex;
 	boolean seenType = FALSE;
@@ -1278,10 +1330,10 @@ static const char *getVarType (const statementInfo *const st,
 			return vStringValue(st->firstToken->name);
 	}
 
-	if (vt == NULL)
-		vt = vStringNew();
+	if (VarType == NULL)
+		VarType = vStringNew();
 	else
-		vStringClear(vt);
+		vStringClear(VarType);
 
 	/* find the end of the type signature in the token list */
 	for (i = 0; i < st->tokenIndex; i++)
@@ -1335,20 +1387,20 @@ static const char *getVarType (const statementInfo *const st,
 					break;
 				}
 				continue;
-			case TOKEN_STAR: vStringCatS(vt, " *"); continue;
-			case TOKEN_ARRAY: vStringCatS(vt, "[]"); continue;
+			case TOKEN_STAR: vStringCatS(VarType, " *"); continue;
+			case TOKEN_ARRAY: vStringCatS(VarType, "[]"); continue;
 			case TOKEN_DOUBLE_COLON:
-				vStringCatS(vt, "::");
+				vStringCatS(VarType, "::");
 				continue;
 			default: continue;
 		}
-		if (vStringLength(vt) > 0)
-			if (isalpha(vStringValue(vt)[vStringLength(vt) - 1]))
-				vStringPut(vt, ' ');
-		vStringCat(vt, t->name);
+		if (vStringLength(VarType) > 0)
+			if (isalpha(vStringValue(VarType)[vStringLength(VarType) - 1]))
+				vStringPut(VarType, ' ');
+		vStringCat(VarType, t->name);
 	}
-	vStringTerminate(vt);
-	return vStringValue(vt);
+	vStringTerminate(VarType);
+	return vStringValue(VarType);
 }
 
 static void addContextSeparator (vString *const scope)
@@ -1374,7 +1426,7 @@ static void findScopeHierarchy (vString *const string,
 	}
 	if (st->parent != NULL)
 	{
-		vString *temp = vStringNew ();
+		vString *temp = newString ();
 		const statementInfo *s;
 
 		for (s = st->parent  ;  s != NULL  ;  s = s->parent)
@@ -1402,7 +1454,7 @@ static void findScopeHierarchy (vString *const string,
 				vStringCat (string, temp);
 			}
 		}
-		vStringDelete (temp);
+		deleteString (temp);
 
 		if (! nonAnonPresent)
 			vStringClear (string);
@@ -1415,7 +1467,7 @@ static void makeExtraTagEntry (const tagType type, tagEntryInfo *const e,
 	if (Option.include.qualifiedTags  &&
 		scope != NULL  &&  vStringLength (scope) > 0)
 	{
-		vString *const scopedName = vStringNew ();
+		vString *const scopedName = newString ();
 
 		if (type != TAG_ENUMERATOR)
 			vStringCopy (scopedName, scope);
@@ -1438,7 +1490,7 @@ static void makeExtraTagEntry (const tagType type, tagEntryInfo *const e,
 			e->name = vStringValue (scopedName);
 			makeTagEntry (e);
 		}
-		vStringDelete (scopedName);
+		deleteString (scopedName);
 	}
 }
 
@@ -1458,7 +1510,7 @@ static void makeTag (const tokenInfo *const token,
 	if (isType (token, TOKEN_NAME)  &&  vStringLength (token->name) > 0  /* &&
 		includeTag (type, isFileScope) */)
 	{
-		vString *scope = vStringNew ();
+		vString *scope;
 		tagEntryInfo e;
 
 		/* take only functions which are introduced by "function ..." */
@@ -1468,6 +1520,8 @@ static void makeTag (const tokenInfo *const token,
 			return;
 		}
 
+		scope = newString ();
+
 		initTagEntry (&e, vStringValue (token->name));
 
 		e.lineNumber	= token->lineNumber;
@@ -1484,9 +1538,9 @@ static void makeTag (const tokenInfo *const token,
 		printTagEntry(&e);
 #endif
 		makeTagEntry (&e);
-		if (NULL != TagEntryFunction)
+		if (NULL != CurrentParse->tagEntryFunction)
 			makeExtraTagEntry (type, &e, scope);
-		vStringDelete (scope);
+		deleteString (scope);
 		if (NULL != e.extensionFields.arglist)
 			free((char *) e.extensionFields.arglist);
 	}
@@ -2869,21 +2923,27 @@ static void nextToken (statementInfo *const st)
 /*
 *   Scanning support functions
 */
-static unsigned int contextual_fake_count = 0;
-static statementInfo *CurrentStatement = NULL;
+static THREAD_LOCAL unsigned int contextual_fake_count = 0;
+static THREAD_LOCAL statementInfo *CurrentStatement = NULL;
 
 static statementInfo *newStatement (statementInfo *const parent)
 {
-	statementInfo *const st = xMalloc (1, statementInfo);
+	statementInfo *st = StatementPool;
 	unsigned int i;
 
-	for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
-		st->token [i] = newToken ();
+	if (st != NULL)
+		StatementPool = st->parent;
+	else
+	{
+		st = xMalloc (1, statementInfo);
+		for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
+			st->token [i] = newToken ();
 
-	st->context			= newToken ();
-	st->blockName		= newToken ();
-	st->parentClasses	= vStringNew ();
-	st->firstToken		= newToken();
+		st->context			= newToken ();
+		st->blockName		= newToken ();
+		st->parentClasses	= vStringNew ();
+		st->firstToken		= newToken();
+	}
 
 	initStatement (st, parent);
 	CurrentStatement = st;
@@ -2891,22 +2951,55 @@ static statementInfo *newStatement (statementInfo *const parent)
 	return st;
 }
 
+/* Puts the current statement back into the pool, its tokens included */
 static void deleteStatement (void)
 {
 	statementInfo *const st = CurrentStatement;
-	statementInfo *const parent = st->parent;
+
+	CurrentStatement = st->parent;
+	st->parent = StatementPool;
+	StatementPool = st;
+}
+
+static void destroyStatement (statementInfo *const st)
+{
 	unsigned int i;
 
 	for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
-	{
-		deleteToken(st->token[i]);			st->token[i] = NULL;
-	}
-	deleteToken(st->blockName);			st->blockName = NULL;
-	deleteToken(st->context);			st->context = NULL;
-	vStringDelete(st->parentClasses);	st->parentClasses = NULL;
-	deleteToken(st->firstToken);
+		destroyToken (st->token [i]);
+	destroyToken (st->blockName);
+	destroyToken (st->context);
+	vStringDelete (st->parentClasses);
+	destroyToken (st->firstToken);
 	eFree (st);
-	CurrentStatement = parent;
+}
+
+static void freeObjectPools (void)
+{
+	tokenInfo *token;
+	vString *string;
+
+	while (StatementPool != NULL)
+	{
+		statementInfo *const st = StatementPool;
+		StatementPool = st->parent;
+		destroyStatement (st);
+	}
+	while ((token = poolTake (&TokenPool)) != NULL)
+		destroyToken (token);
+	while ((string = poolTake (&StringPool)) != NULL)
+		vStringDelete (string);
+	if (TokenPool.items != NULL)
+		eFree (TokenPool.items);
+	if (StringPool.items != NULL)
+		eFree (StringPool.items);
+	TokenPool.items = NULL;
+	TokenPool.size = 0;
+	StringPool.items = NULL;
+	StringPool.size = 0;
+	if (VarType != NULL)
+		vStringDelete (VarType);
+	VarType = NULL;
 }
 
 static void deleteAllStatements (void)
@@ -3192,6 +3285,7 @@ static boolean findCTags (const unsigned int passCount)
 		}
 	}
 	cppTerminate ();
+	freeObjectPools ();
 	return retry;
 }
 
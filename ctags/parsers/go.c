@@ -77,8 +77,8 @@ typedef struct sTokenInfo {
 */
 
 static int Lang_go;
-static vString *scope;
-static vString *signature = NULL;
+static THREAD_LOCAL vString *scope;
+static THREAD_LOCAL vString *signature = NULL;
 
 typedef enum {
 	GOTAG_UNDEFINED = -1,
@@ -219,7 +219,7 @@ static void parseIdentifier (vString *const string, const int firstChar)
 static void readToken (tokenInfo *const token)
 {
 	int c;
-	static tokenType lastTokenType = TOKEN_NONE;
+	static THREAD_LOCAL tokenType lastTokenType = TOKEN_NONE;
 	boolean firstWhitespace = TRUE;
 	boolean whitespace;
 
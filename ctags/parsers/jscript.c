@@ -43,8 +43,8 @@
 /*
  * Tracks class and function names already created
  */
-static stringList *ClassNames;
-static stringList *FunctionNames;
+static THREAD_LOCAL stringList *ClassNames;
+static THREAD_LOCAL stringList *FunctionNames;
 
 /*	Used to specify type of keyword.
 */
@@ -120,7 +120,7 @@ typedef struct sTokenInfo {
  *	DATA DEFINITIONS
  */
 
-static tokenType LastTokenType;
+static THREAD_LOCAL tokenType LastTokenType;
 
 static langType Lang_js;
 
@@ -229,16 +229,18 @@ typedef struct {
 static langType Lang_php;
 static langType Lang_zephir;
 
-static boolean InPhp = FALSE; /* whether we are between <? ?> */
+static THREAD_LOCAL boolean InPhp = FALSE; /* whether we are between <? ?> */
 
 /* current statement details */
-static struct {
+static THREAD_LOCAL struct {
 	accessType access;
 	implType impl;
 } CurrentStatement;
 
 /* Current namespace */
-static vString *CurrentNamespace;
+static THREAD_LOCAL vString *CurrentNamespace;
+
+static THREAD_LOCAL vString *FullScope = NULL;	/* used by initPhpEntry() */
 
 
 static void buildPhpKeywordHash (const langType language)
@@ -281,17 +283,16 @@ static const char *implToString (const implType impl)
 static void initPhpEntry (tagEntryInfo *const e, const tokenInfo *const token,
 						  const phpKind kind, const accessType access)
 {
-	static vString *fullScope = NULL;
 	int parentKind = -1;
 
-	if (fullScope == NULL)
-		fullScope = vStringNew ();
+	if (FullScope == NULL)
+		FullScope = vStringNew ();
 	else
-		vStringClear (fullScope);
+		vStringClear (FullScope);
 
 	if (vStringLength (CurrentNamespace) > 0)
 	{
-		vStringCopy (fullScope, CurrentNamespace);
+		vStringCopy (FullScope, CurrentNamespace);
 		parentKind = K_NAMESPACE;
 	}
 
@@ -307,17 +308,17 @@ static void initPhpEntry (tagEntryInfo *const e, const tokenInfo *const token,
 	if (vStringLength (token->scope) > 0)
 	{
 		parentKind = token->parentKind;
-		if (vStringLength (fullScope) > 0)
-			vStringCatS (fullScope, SCOPE_SEPARATOR);
-		vStringCat (fullScope, token->scope);
+		if (vStringLength (FullScope) > 0)
+			vStringCatS (FullScope, SCOPE_SEPARATOR);
+		vStringCat (FullScope, token->scope);
 	}
-	if (vStringLength (fullScope) > 0)
+	if (vStringLength (FullScope) > 0)
 	{
 		Assert (parentKind >= 0);
 
-		vStringTerminate (fullScope);
+		vStringTerminate (FullScope);
 		e->extensionFields.scope[0] = PhpKinds[parentKind].name;
-		e->extensionFields.scope[1] = vStringValue (fullScope);
+		e->extensionFields.scope[1] = vStringValue (FullScope);
 	}
 }
 
@@ -1462,6 +1463,9 @@ static void findTags (void)
 	while (token->type != TOKEN_EOF); /* keep going even with unmatched braces */
 
 	vStringDelete (CurrentNamespace);
+	if (FullScope != NULL)
+		vStringDelete (FullScope);
+	FullScope = NULL;
 	deleteToken (token);
 }
 
@@ -45,7 +45,7 @@ static kindOption RubyKinds [] = {
 #endif
 };
 
-static NestingLevels* nesting = NULL;
+static THREAD_LOCAL NestingLevels* nesting = NULL;
 
 #define SCOPE_SEPARATOR '.'
 
@@ -1256,6 +1256,20 @@ static void on_menu_write_unicode_bom1_toggled(GtkCheckMenuItem *checkmenuitem,
 }
 
 
+static void on_menu_large_file_mode1_toggled(GtkCheckMenuItem *checkmenuitem, gpointer user_data)
+{
+	if (! ignore_callback)
+	{
+		GeanyDocument *doc = document_get_current();
+
+		g_return_if_fail(doc != NULL);
+		/* the item is only sensitive in large file mode, so it can only be left */
+		if (doc->priv->large_file)
+			document_leave_large_file_mode(doc);
+	}
+}
+
+
 void on_menu_comment_line1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
 	GeanyDocument *doc = document_get_current();
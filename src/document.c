@@ -108,7 +108,26 @@ enum
 
 static guint doc_id_counter = 0;
 
-
+/* size of the pieces the text of a file is given to Scintilla in, see set_text_from_buffer() */
+#define LOAD_CHUNK_SIZE (1024 * 1024)
+
+/* number of files read concurrently by document_prefetch_file(), so that their I/O overlaps */
+#define PREFETCH_THREADS 4
+/* the workers don't start reading another file while this much prefetched data waits to be
+ * claimed, so the read-ahead of a long list of files stays bounded */
+#define PREFETCH_MAX_SIZE (128 * 1024 * 1024)
+
+static GThreadPool *prefetch_pool = NULL;
+static GHashTable *prefetch_jobs = NULL;	/* locale filename -> PrefetchJob, main thread only */
+static GMutex prefetch_mutex;
+static GCond prefetch_cond;
+static gsize prefetch_size = 0;	/* length of the loaded, unclaimed files, protected by prefetch_mutex */
+static guint prefetch_converting = 0;	/* number of files being decoded, protected by prefetch_mutex */
+static GQueue open_queue = G_QUEUE_INIT;	/* OpenRequest, see document_open_files_async() */
+
+
+static void open_request_free(gpointer data);
+static gboolean open_queued_files(gpointer data);
 static void document_undo_clear_stack(GTrashStack **stack);
 static void document_undo_clear(GeanyDocument *doc);
 static void document_undo_add_internal(GeanyDocument *doc, guint type, gpointer data);
@@ -391,6 +410,21 @@ void document_finalize(void)
 {
 	guint i;
 
+	g_queue_foreach(&open_queue, (GFunc) open_request_free, NULL);
+	g_queue_clear(&open_queue);
+	if (prefetch_pool != NULL)
+	{
+		g_hash_table_destroy(prefetch_jobs);
+		/* don't wait for running reads, they may hang on a slow file system; the workers
+		 * free the cancelled jobs they still hold. Only wait for the decoding, which is quick
+		 * but uses the encodings freed after us. */
+		g_mutex_lock(&prefetch_mutex);
+		while (prefetch_converting > 0)
+			g_cond_wait(&prefetch_cond, &prefetch_mutex);
+		g_mutex_unlock(&prefetch_mutex);
+		g_thread_pool_free(prefetch_pool, FALSE, FALSE);
+	}
+
 	for (i = 0; i < documents_array->len; i++)
 		g_free(documents[i]);
 	g_ptr_array_free(documents_array, TRUE);
@@ -649,6 +683,7 @@ static GeanyDocument *document_create(const gchar *utf8_filename)
 
 	/* initialize default document settings */
 	doc->priv = g_new0(GeanyDocumentPrivate, 1);
+	doc->priv->disk_stamp.mtime = -1;
 	doc->id = ++doc_id_counter;
 	doc->index = new_idx;
 	doc->file_name = g_strdup(utf8_filename);
@@ -916,14 +951,46 @@ typedef struct
 	gchar		*enc;
 	gboolean	 bom;
 	time_t		 mtime;	/* modification time, read by stat::st_mtime */
+	TMFileStamp	 stamp;	/* state of the file on disk before it was read, mtime -1 if unknown */
 	gboolean	 readonly;
+	gint		 eol_mode;	/* line endings detected in data */
+	IndentStats	 indent_stats;
+	gsize		 longest_line;	/* length of the longest line in data */
+	gchar		*error;	/* why the file could not be loaded, NULL on success */
 } FileData;
 
 
-static gboolean get_mtime(const gchar *locale_filename, time_t *time)
+/* A file being read in the background by document_prefetch_file() */
+typedef struct
+{
+	gchar		*locale_filename;
+	gchar		*display_filename;
+	gchar		*forced_enc;
+	FileData	 filedata;
+	gboolean	 async;	/* opened by document_open_files_async(), written under prefetch_mutex */
+	gboolean	 started;	/* protected by prefetch_mutex */
+	gboolean	 loaded;	/* protected by prefetch_mutex */
+	gboolean	 cancelled;	/* protected by prefetch_mutex */
+} PrefetchJob;
+
+
+/* A file queued by document_open_files_async() */
+typedef struct
+{
+	gchar			*locale_filename;
+	gboolean		 readonly;
+	GeanyFiletype	*ft;
+	gchar			*forced_enc;
+} OpenRequest;
+
+
+/* Gets the modification time of locale_filename without touching the UI, so it can be
+ * used from any thread. Returns a newly allocated error message on failure. */
+static gchar *query_mtime(const gchar *locale_filename, time_t *time)
 {
 	GError *error = NULL;
 	const gchar *err_msg = NULL;
+	gchar *message = NULL;
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
@@ -957,21 +1024,199 @@ static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 	{
 		gchar *utf8_filename = utils_get_utf8_from_locale(locale_filename);
 
-		ui_set_statusbar(TRUE, _("Could not open file %s (%s)"),
-			utf8_filename, err_msg);
+		message = g_strdup_printf(_("Could not open file %s (%s)"), utf8_filename, err_msg);
 		g_free(utf8_filename);
 	}
 
 	if (error)
 		g_error_free(error);
 
-	return err_msg == NULL;
+	return message;
 }
 
 
-/* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM. */
-static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
-	FileData *filedata, const gchar *forced_enc)
+/* Checks whether the file is still in the state it was in when it was loaded or saved,
+ * and whether all of it is in the buffer */
+static gboolean file_unchanged_on_disk(GeanyDocument *doc, const gchar *locale_filename)
+{
+	const TMFileStamp *old = &doc->priv->disk_stamp;
+	TMFileStamp stamp;
+
+	if (old->mtime == -1 || ! tm_source_file_get_stamp(locale_filename, &stamp))
+		return FALSE;
+
+	/* the size also tells whether the text was cut at a NUL byte on load */
+	return stamp.mtime == old->mtime && stamp.ctime == old->ctime &&
+		stamp.size == old->size && stamp.inode == old->inode &&
+		stamp.size == sci_get_length(doc->editor->sci);
+}
+
+
+static gboolean get_mtime(const gchar *locale_filename, time_t *time)
+{
+	gchar *err_msg = query_mtime(locale_filename, time);
+
+	if (err_msg)
+	{
+		ui_set_statusbar(TRUE, "%s", err_msg);
+		g_free(err_msg);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Gets the width of the indentation made of the spaces and tabs in [start, end) */
+static gsize measure_indent(const gchar *start, const gchar *end, gsize tab_width)
+{
+	gsize width = 0;
+
+	for (; start < end; start++)
+	{
+		if (*start == '\t')
+			width = (width / tab_width + 1) * tab_width;
+		else
+			width++;
+	}
+	return width;
+}
+
+
+/* Gets the largest tab width up to INDENT_STATS_MAX_WIDTH for which the indentation made of
+ * the spaces and n_tabs tabs in [start, end) is at most 24 columns, or 0 if there is none */
+static guint get_max_tab_width(const gchar *start, const gchar *end, gsize n_tabs)
+{
+	guint tab_width;
+
+	if (n_tabs == 0)
+		return (end - start) <= 24 ? INDENT_STATS_MAX_WIDTH : 0;
+	if (n_tabs == (gsize) (end - start))
+		return MIN(INDENT_STATS_MAX_WIDTH, 24 / n_tabs);
+
+	for (tab_width = INDENT_STATS_MAX_WIDTH; tab_width > 0; tab_width--)
+	{
+		if (measure_indent(start, end, tab_width) <= 24)
+			break;
+	}
+	return tab_width;
+}
+
+
+/* Adds the indentation of the line starting at line to stats; end is at or after the end
+ * of the line */
+static void analyse_line_indent(const gchar *line, const gchar *end, IndentStats *stats)
+{
+	const gchar *p = line;
+	gsize n_tabs = 0;
+	gsize width;
+	gint i;
+
+	/* tabs followed by spaces then something else, see detect_tabs_and_spaces() */
+	while (p < end && *p == '\t')
+		p++;
+	if (p > line)
+	{
+		const gchar *spaces = p;
+
+		while (p < end && *p == ' ')
+			p++;
+		if (p < end && *p != '\r' && *p != '\n' && p - spaces <= INDENT_STATS_MAX_WIDTH)
+			stats->mixed_lines[p - spaces]++;
+	}
+
+	for (p = line; p < end && (*p == ' ' || *p == '\t'); p++)
+	{
+		if (*p == '\t')
+			n_tabs++;
+	}
+	if (p == line)
+		return;
+
+	/* see document_detect_indent_type() */
+	if (line[0] == '\t')
+		stats->tab_lines[get_max_tab_width(line, p, n_tabs)]++;
+	else if (line + 1 < end && line[1] == ' ')
+		stats->space_lines[get_max_tab_width(line, p, n_tabs)]++;
+
+	/* see detect_indent_width() */
+	if (p < end && *p == '*')
+		return;
+	width = n_tabs ? measure_indent(line, p, 8) : (gsize) (p - line);
+	if (width < 2 || width > 24)
+		return;
+	for (i = G_N_ELEMENTS(stats->widths) - 1; i >= 0; i--)
+	{
+		if ((width % (i + 2)) == 0)
+			stats->widths[i]++;
+	}
+}
+
+
+static const gchar *find_char(const gchar *start, const gchar *end, gchar c)
+{
+	const gchar *found = memchr(start, c, end - start);
+
+	return found ? found : end;
+}
+
+
+/* Detects the line endings of text and gathers its indentation statistics and the length of
+ * its longest line in a single pass.
+ * Line breaks are searched with memchr(), which the C library usually vectorises. */
+static gint analyse_text(const gchar *text, gsize len, IndentStats *stats, gsize *longest_line)
+{
+	const gchar *end = text + len;
+	const gchar *p = text;
+	const gchar *lf;
+	gsize cr_count = 0, lf_count = 0, crlf_count = 0;
+
+	memset(stats, 0, sizeof *stats);
+	stats->lines = 1;
+	*longest_line = 0;
+
+	lf = find_char(p, end, '\n');
+	while (p < end)
+	{
+		const gchar *cr;
+
+		analyse_line_indent(p, lf, stats);
+
+		cr = memchr(p, '\r', lf - p);
+		*longest_line = MAX(*longest_line, (gsize) ((cr ? cr : lf) - p));
+		if (cr != NULL)
+		{
+			if (cr + 1 == lf && lf < end)
+			{
+				crlf_count++;
+				p = lf + 1;
+			}
+			else
+			{
+				cr_count++;
+				p = cr + 1;
+			}
+		}
+		else if (lf < end)
+		{
+			lf_count++;
+			p = lf + 1;
+		}
+		else
+			break;
+
+		stats->lines++;
+		/* only look for the next LF once past the previous one, not to scan the rest of
+		 * the text again for each line of files using CR line endings */
+		if (lf < p)
+			lf = find_char(p, end, '\n');
+	}
+
+	return utils_get_line_endings_from_counts(cr_count, lf_count, crlf_count);
+}
+
+
+/* Loads the raw textfile data, the I/O part of read_text_file(). */
+static void load_text_file(const gchar *locale_filename, FileData *filedata)
 {
 	GError *err = NULL;
 
@@ -980,9 +1225,16 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	filedata->enc = NULL;
 	filedata->bom = FALSE;
 	filedata->readonly = FALSE;
+	filedata->eol_mode = GEANY_DEFAULT_EOL_CHARACTER;
+	filedata->longest_line = 0;
+	filedata->error = query_mtime(locale_filename, &filedata->mtime);
 
-	if (!get_mtime(locale_filename, &filedata->mtime))
-		return FALSE;
+	if (filedata->error)
+		return;
+
+	/* taken before reading, so that a change while reading is noticed later */
+	if (! tm_source_file_get_stamp(locale_filename, &filedata->stamp))
+		filedata->stamp.mtime = -1;
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
@@ -996,26 +1248,64 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 
 	if (err)
 	{
-		ui_set_statusbar(TRUE, "%s", err->message);
+		filedata->error = g_strdup(err->message);
 		g_error_free(err);
-		return FALSE;
 	}
+}
+
+
+/* Verifies and converts the data loaded by load_text_file() to forced_enc or UTF-8, handles
+ * BOM and analyses the line endings and indentation. */
+static void convert_text_file(const gchar *display_filename, FileData *filedata,
+	const gchar *forced_enc)
+{
+	if (filedata->error)
+		return;
 
 	if (! encodings_convert_to_utf8_auto(&filedata->data, &filedata->len, forced_enc,
 				&filedata->enc, &filedata->bom, &filedata->readonly))
 	{
 		if (forced_enc)
 		{
-			ui_set_statusbar(TRUE, _("The file \"%s\" is not valid %s."),
+			filedata->error = g_strdup_printf(_("The file \"%s\" is not valid %s."),
 				display_filename, forced_enc);
 		}
 		else
 		{
-			ui_set_statusbar(TRUE,
+			filedata->error = g_strdup_printf(
 	_("The file \"%s\" does not look like a text file or the file encoding is not supported."),
 			display_filename);
 		}
 		g_free(filedata->data);
+		filedata->data = NULL;
+		return;
+	}
+
+	filedata->eol_mode = analyse_text(filedata->data, filedata->len, &filedata->indent_stats,
+		&filedata->longest_line);
+}
+
+
+/* Loads textfile data, verifies and converts to forced_enc or UTF-8, handles BOM and analyses
+ * the line endings and indentation. This doesn't touch the UI so it can run on a worker
+ * thread; on failure filedata->error is set and should be reported with check_loaded_file(). */
+static void read_text_file(const gchar *locale_filename, const gchar *display_filename,
+	FileData *filedata, const gchar *forced_enc)
+{
+	load_text_file(locale_filename, filedata);
+	convert_text_file(display_filename, filedata, forced_enc);
+}
+
+
+/* Reports the outcome of read_text_file() to the user.
+ * Returns: FALSE if the file could not be loaded. */
+static gboolean check_loaded_file(const gchar *display_filename, FileData *filedata)
+{
+	if (filedata->error)
+	{
+		ui_set_statusbar(TRUE, "%s", filedata->error);
+		g_free(filedata->error);
+		filedata->error = NULL;
 		return FALSE;
 	}
 
@@ -1036,6 +1326,341 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 }
 
 
+static void prefetch_job_free(PrefetchJob *job)
+{
+	g_free(job->locale_filename);
+	g_free(job->display_filename);
+	g_free(job->forced_enc);
+	g_free(job->filedata.data);
+	g_free(job->filedata.enc);
+	g_free(job->filedata.error);
+	g_free(job);
+}
+
+
+static void prefetch_job_run(gpointer data, gpointer user_data)
+{
+	PrefetchJob *job = data;
+	gboolean cancelled;
+	gboolean async;
+
+	/* wait until enough of the files read before have been claimed */
+	g_mutex_lock(&prefetch_mutex);
+	while (! job->cancelled && prefetch_size >= PREFETCH_MAX_SIZE)
+		g_cond_wait(&prefetch_cond, &prefetch_mutex);
+	job->started = TRUE;
+	cancelled = job->cancelled;
+	g_mutex_unlock(&prefetch_mutex);
+
+	if (! cancelled)
+		load_text_file(job->locale_filename, &job->filedata);
+
+	/* the read may have taken long, don't bother decoding a file nobody waits for anymore;
+	 * document_finalize() waits for the decoding, as it uses the encodings */
+	g_mutex_lock(&prefetch_mutex);
+	cancelled = job->cancelled;
+	if (! cancelled)
+		prefetch_converting++;
+	g_mutex_unlock(&prefetch_mutex);
+
+	if (! cancelled)
+		convert_text_file(job->display_filename, &job->filedata, job->forced_enc);
+
+	g_mutex_lock(&prefetch_mutex);
+	if (! cancelled)
+		prefetch_converting--;
+	job->loaded = TRUE;
+	cancelled = job->cancelled;
+	async = job->async;
+	if (! cancelled)
+		prefetch_size += job->filedata.len;
+	g_cond_broadcast(&prefetch_cond);
+	g_mutex_unlock(&prefetch_mutex);
+
+	/* nobody is going to claim a cancelled job anymore */
+	if (cancelled)
+		prefetch_job_free(job);
+	else if (async)
+		g_idle_add(open_queued_files, NULL);
+}
+
+
+/* Cancels a job that was removed from prefetch_jobs; whichever of us and the worker
+ * is done with it last frees it. */
+static void prefetch_job_cancel(gpointer data)
+{
+	PrefetchJob *job = data;
+	gboolean loaded;
+
+	g_mutex_lock(&prefetch_mutex);
+	job->cancelled = TRUE;
+	loaded = job->loaded;
+	if (loaded)
+		prefetch_size -= job->filedata.len;
+	g_cond_broadcast(&prefetch_cond);
+	g_mutex_unlock(&prefetch_mutex);
+
+	if (loaded)
+		prefetch_job_free(job);
+}
+
+
+/* Gets the locale filename document_open_file_full() uses for filename. */
+static gchar *get_open_locale_filename(const gchar *filename)
+{
+	gchar *locale_filename;
+
+#ifdef G_OS_WIN32
+	/* if filename is a shortcut, try to resolve it */
+	locale_filename = win32_get_shortcut_target(filename);
+#else
+	locale_filename = g_strdup(filename);
+#endif
+	/* remove relative junk */
+	utils_tidy_path(locale_filename);
+
+	return locale_filename;
+}
+
+
+static void prefetch_file(const gchar *filename, const gchar *forced_enc, gboolean async)
+{
+	PrefetchJob *job;
+	PrefetchJob *queued;
+	gchar *utf8_filename;
+
+	if (prefetch_pool == NULL)
+	{
+		prefetch_pool = g_thread_pool_new(prefetch_job_run, NULL, PREFETCH_THREADS, FALSE, NULL);
+		prefetch_jobs = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, prefetch_job_cancel);
+	}
+
+	job = g_new0(PrefetchJob, 1);
+	job->locale_filename = get_open_locale_filename(filename);
+
+	/* already open or already being prefetched */
+	utf8_filename = utils_get_utf8_from_locale(job->locale_filename);
+	queued = g_hash_table_lookup(prefetch_jobs, job->locale_filename);
+	if (document_find_by_filename(utf8_filename) != NULL || queued != NULL)
+	{
+		if (queued != NULL && async)
+		{
+			g_mutex_lock(&prefetch_mutex);
+			queued->async = TRUE;
+			g_mutex_unlock(&prefetch_mutex);
+		}
+		g_free(utf8_filename);
+		prefetch_job_free(job);
+		return;
+	}
+
+	job->display_filename = utils_str_middle_truncate(utf8_filename, 100);
+	job->forced_enc = g_strdup(forced_enc);
+	job->async = async;
+	g_free(utf8_filename);
+
+	g_hash_table_insert(prefetch_jobs, job->locale_filename, job);
+	g_thread_pool_push(prefetch_pool, job, NULL);
+}
+
+
+/* Starts reading filename on a worker thread, so that the I/O and decoding of several files
+ * about to be opened overlap each other and the setup of the documents opened before.
+ * The next document_open_file_full() call for the same file and encoding waits for and
+ * uses the result, other prefetched files are dropped by document_prefetch_cancel().
+ * filename should be locale encoded. */
+void document_prefetch_file(const gchar *filename, const gchar *forced_enc)
+{
+	g_return_if_fail(filename != NULL);
+
+	prefetch_file(filename, forced_enc, FALSE);
+}
+
+
+static gboolean is_sync_prefetch_job(gpointer key, gpointer value, gpointer user_data)
+{
+	PrefetchJob *job = value;
+
+	return ! job->async;
+}
+
+
+/* Drops all prefetched files that have not been opened (yet), except the ones
+ * document_open_files_async() is going to open. */
+void document_prefetch_cancel(void)
+{
+	if (prefetch_jobs != NULL)
+		g_hash_table_foreach_remove(prefetch_jobs, is_sync_prefetch_job, NULL);
+}
+
+
+/* Whether claim_prefetched_file() would have to wait for the job. */
+static gboolean prefetch_job_pending(PrefetchJob *job)
+{
+	gboolean pending;
+
+	g_mutex_lock(&prefetch_mutex);
+	pending = ! job->loaded && (job->started || prefetch_size < PREFETCH_MAX_SIZE);
+	g_mutex_unlock(&prefetch_mutex);
+
+	return pending;
+}
+
+
+/* Waits for the prefetched data of locale_filename, if any.
+ * Returns: TRUE if filedata was filled in, in which case the caller owns its contents. */
+static gboolean claim_prefetched_file(const gchar *locale_filename, const gchar *forced_enc,
+		FileData *filedata)
+{
+	PrefetchJob *job;
+	gboolean loaded;
+
+	if (prefetch_jobs == NULL)
+		return FALSE;
+
+	job = g_hash_table_lookup(prefetch_jobs, locale_filename);
+	if (job == NULL)
+		return FALSE;
+	if (! utils_str_equal(job->forced_enc, forced_enc))
+	{
+		g_hash_table_remove(prefetch_jobs, locale_filename);
+		return FALSE;
+	}
+	g_hash_table_steal(prefetch_jobs, locale_filename);
+
+	g_mutex_lock(&prefetch_mutex);
+	/* a job not started yet may wait for files after it to be claimed, read it ourselves then */
+	while (! job->loaded && (job->started || prefetch_size < PREFETCH_MAX_SIZE))
+		g_cond_wait(&prefetch_cond, &prefetch_mutex);
+	loaded = job->loaded;
+	if (loaded)
+		prefetch_size -= job->filedata.len;
+	else
+		job->cancelled = TRUE;
+	g_cond_broadcast(&prefetch_cond);
+	g_mutex_unlock(&prefetch_mutex);
+
+	/* the worker frees a cancelled job */
+	if (! loaded)
+		return FALSE;
+
+	*filedata = job->filedata;
+	job->filedata.data = NULL;
+	job->filedata.enc = NULL;
+	job->filedata.error = NULL;
+	prefetch_job_free(job);
+	return TRUE;
+}
+
+
+/* Replaces the text of sci with data, which is freed. The text is inserted piece by piece
+ * starting from its end, and data is shrunk after each piece, so that the text of a large file
+ * is not held both by us and by Scintilla at once. Undo collection should be off, otherwise
+ * each piece would be an undo action, and nothing should be connected to "sci-notify" yet. */
+static void set_text_from_buffer(ScintillaObject *sci, gchar *data, gsize len)
+{
+	gsize end = len;
+
+	sci_clear_all(sci);
+	sci_allocate(sci, (gint) len);
+
+	while (end > 0)
+	{
+		gsize start = end > LOAD_CHUNK_SIZE ? end - LOAD_CHUNK_SIZE : 0;
+		gsize limit = start > LOAD_CHUNK_SIZE / 2 ? start - LOAD_CHUNK_SIZE / 2 : 0;
+		gsize pos;
+
+		/* start the piece after a line break, not to split a character */
+		for (pos = start; pos > limit && data[pos - 1] != '\n'; pos--);
+		if (pos > limit)
+			start = pos;
+		else
+		{	/* very long line, at least don't split a multibyte character */
+			while (start > 0 && ((guchar) data[start] & 0xC0) == 0x80)
+				start--;
+		}
+
+		data[end] = '\0';
+		sci_insert_text(sci, 0, data + start);
+
+		end = start;
+		data = g_realloc(data, end + 1);
+	}
+	g_free(data);
+}
+
+
+/* Whether a file is large enough to be opened in large file mode, where all the features
+ * working on the whole document are disabled */
+static gboolean is_large_file(const FileData *filedata)
+{
+	return (file_prefs.large_file_size > 0 &&
+			filedata->len >= (gsize) file_prefs.large_file_size * 1024 * 1024) ||
+		(file_prefs.large_file_line_length > 0 &&
+			filedata->longest_line >= (gsize) file_prefs.large_file_line_length);
+}
+
+
+/* Enables the features disabled when doc was opened in large file mode */
+void document_leave_large_file_mode(GeanyDocument *doc)
+{
+	GtkWidget *bar = doc->priv->info_bars[MSG_TYPE_LARGE_FILE];
+
+	g_return_if_fail(doc->priv->large_file);
+
+	doc->priv->large_file = FALSE;
+	if (bar != NULL)
+	{
+		doc->priv->info_bars[MSG_TYPE_LARGE_FILE] = NULL;
+		gtk_widget_destroy(bar);
+	}
+
+	/* unless the user already chose a filetype, use the one asked for when opening */
+	if (doc->file_type->id == GEANY_FILETYPES_NONE)
+	{
+		GeanyFiletype *ft = doc->priv->large_file_ft;
+
+		document_set_filetype(doc, (ft != NULL) ? ft : filetypes_detect_from_document(doc));
+	}
+	else
+		document_update_tags(doc);
+	doc->priv->large_file_ft = NULL;
+
+	queue_colourise(doc);
+	ui_update_statusbar(doc, -1);
+	ui_document_show_hide(doc);
+}
+
+
+static void on_large_file_response(GtkWidget *bar, gint response_id, GeanyDocument *doc)
+{
+	if (response_id == GTK_RESPONSE_ACCEPT)
+		document_leave_large_file_mode(doc);
+	else
+	{
+		doc->priv->info_bars[MSG_TYPE_LARGE_FILE] = NULL;
+		gtk_widget_destroy(bar);
+	}
+}
+
+
+static void show_large_file_message(GeanyDocument *doc)
+{
+	gchar *base_name = g_path_get_basename(DOC_FILENAME(doc));
+
+	doc->priv->info_bars[MSG_TYPE_LARGE_FILE] = document_show_message(doc, GTK_MESSAGE_INFO,
+		on_large_file_response,
+		_("_Enable All Features"), GTK_RESPONSE_ACCEPT,
+		GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE,
+		NULL, GTK_RESPONSE_NONE,
+		_("Syntax highlighting, folding, symbols, brace matching and document word "
+		"completion are disabled to keep the editor responsive."),
+		_("The file \"%s\" is large."), base_name);
+
+	g_free(base_name);
+}
+
+
 /* Sets the cursor position on opening a file. First it sets the line when cl_options.goto_line
  * is set, otherwise it sets the line when pos is greater than zero and finally it sets the column
  * if cl_options.goto_column is set.
@@ -1069,15 +1694,22 @@ static gint set_cursor_position(GeanyEditor *editor, gint pos)
 
 
 /* Count lines that start with some hard tabs then a soft tab. */
-static gboolean detect_tabs_and_spaces(GeanyEditor *editor)
+static gboolean detect_tabs_and_spaces(GeanyDocument *doc)
 {
+	GeanyEditor *editor = doc->editor;
 	const GeanyIndentPrefs *iprefs = editor_get_indent_prefs(editor);
+	const IndentStats *stats = doc->priv->indent_stats;
 	ScintillaObject *sci = editor->sci;
 	gsize count = 0;
 	struct Sci_TextToFind ttf;
-	gchar *soft_tab = g_strnfill((gsize)iprefs->width, ' ');
-	gchar *regex = g_strconcat("^\t+", soft_tab, "[^ ]", NULL);
+	gchar *soft_tab;
+	gchar *regex;
 
+	if (stats != NULL && iprefs->width > 0 && iprefs->width <= INDENT_STATS_MAX_WIDTH)
+		return stats->mixed_lines[iprefs->width] > stats->lines * 0.02;
+
+	soft_tab = g_strnfill((gsize)iprefs->width, ' ');
+	regex = g_strconcat("^\t+", soft_tab, "[^ ]", NULL);
 	g_free(soft_tab);
 
 	ttf.chrg.cpMin = 0;
@@ -1104,17 +1736,30 @@ static gboolean detect_tabs_and_spaces(GeanyEditor *editor)
 gboolean document_detect_indent_type(GeanyDocument *doc, GeanyIndentType *type_)
 {
 	GeanyEditor *editor = doc->editor;
+	const IndentStats *stats = doc->priv->indent_stats;
 	ScintillaObject *sci = editor->sci;
-	gint line, line_count;
+	gint line, line_count, tab_width;
 	gsize tabs = 0, spaces = 0;
 
-	if (detect_tabs_and_spaces(editor))
+	if (detect_tabs_and_spaces(doc))
 	{
 		*type_ = GEANY_INDENT_TYPE_BOTH;
 		return TRUE;
 	}
 
-	line_count = sci_get_line_count(sci);
+	tab_width = sci_get_tab_width(sci);
+	if (stats != NULL && tab_width > 0 && tab_width <= INDENT_STATS_MAX_WIDTH)
+	{
+		for (; tab_width <= INDENT_STATS_MAX_WIDTH; tab_width++)
+		{
+			tabs += stats->tab_lines[tab_width];
+			spaces += stats->space_lines[tab_width];
+		}
+		line_count = 0;	/* no need to look at the lines */
+	}
+	else
+		line_count = sci_get_line_count(sci);
+
 	for (line = 0; line < line_count; line++)
 	{
 		gint pos = sci_get_position_from_line(sci, line);
@@ -1149,13 +1794,16 @@ gboolean document_detect_indent_type(GeanyDocument *doc, GeanyIndentType *type_)
 
 /* Detect the indent width based on counting the leading indent characters for each line.
  * Returns whether detection succeeded, and the detected width in *width_ upon success */
-static gboolean detect_indent_width(GeanyEditor *editor, GeanyIndentType type, gint *width_)
+static gboolean detect_indent_width(GeanyDocument *doc, GeanyIndentType type, gint *width_)
 {
+	GeanyEditor *editor = doc->editor;
 	const GeanyIndentPrefs *iprefs = editor_get_indent_prefs(editor);
+	const IndentStats *stats = doc->priv->indent_stats;
 	ScintillaObject *sci = editor->sci;
 	gint line, line_count;
-	gint widths[7] = { 0 }; /* width can be from 2 to 8 */
-	gint count, width, i;
+	gsize widths[7] = { 0 }; /* width can be from 2 to 8 */
+	gsize count;
+	gint width, i;
 
 	/* can't easily detect the supposed width of a tab, guess the default is OK */
 	if (type == GEANY_INDENT_TYPE_TABS)
@@ -1164,7 +1812,14 @@ static gboolean detect_indent_width(GeanyEditor *editor, GeanyIndentType type, g
 	/* force 8 at detection time for tab & spaces -- anyway we don't use tabs at this point */
 	sci_set_tab_width(sci, 8);
 
-	line_count = sci_get_line_count(sci);
+	if (stats != NULL)
+	{
+		memcpy(widths, stats->widths, sizeof widths);
+		line_count = 0;	/* no need to look at the lines */
+	}
+	else
+		line_count = sci_get_line_count(sci);
+
 	for (line = 0; line < line_count; line++)
 	{
 		gint pos = sci_get_line_indent_position(sci, line);
@@ -1215,7 +1870,7 @@ static gboolean detect_indent_width(GeanyEditor *editor, GeanyIndentType type, g
 /* same as detect_indent_width() but uses editor's indent type */
 gboolean document_detect_indent_width(GeanyDocument *doc, gint *width_)
 {
-	return detect_indent_width(doc->editor, doc->editor->indent_type, width_);
+	return detect_indent_width(doc, doc->editor->indent_type, width_);
 }
 
 
@@ -1252,7 +1907,7 @@ void document_apply_indent_settings(GeanyDocument *doc)
 	else if (doc->file_type->indent_type > -1)
 		type = doc->file_type->indent_type;
 
-	if (iprefs->detect_width && detect_indent_width(doc->editor, type, &width))
+	if (iprefs->detect_width && detect_indent_width(doc, type, &width))
 	{
 		if (width != iprefs->width)
 		{
@@ -1304,14 +1959,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		/* filename must not be NULL when opening a file */
 		g_return_val_if_fail(filename, NULL);
 
-#ifdef G_OS_WIN32
-		/* if filename is a shortcut, try to resolve it */
-		locale_filename = win32_get_shortcut_target(filename);
-#else
-		locale_filename = g_strdup(filename);
-#endif
-		/* remove relative junk */
-		utils_tidy_path(locale_filename);
+		locale_filename = get_open_locale_filename(filename);
 
 		/* try to get the UTF-8 equivalent for the filename, fallback to filename if error */
 		utf8_filename = utils_get_utf8_from_locale(locale_filename);
@@ -1330,7 +1978,10 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	{	/* doc possibly changed */
 		display_filename = utils_str_middle_truncate(utf8_filename, 100);
 
-		if (! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
+		if (reload || ! claim_prefetched_file(locale_filename, forced_enc, &filedata))
+			read_text_file(locale_filename, display_filename, &filedata, forced_enc);
+
+		if (! check_loaded_file(display_filename, &filedata))
 		{
 			g_free(display_filename);
 			g_free(utf8_filename);
@@ -1378,11 +2029,18 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 		/* add the text to the ScintillaObject */
 		sci_set_readonly(doc->editor->sci, FALSE);	/* to allow replacing text */
-		sci_set_text(doc->editor->sci, filedata.data);	/* NULL terminated data */
+		if (reload)
+			sci_set_text(doc->editor->sci, filedata.data);	/* NULL terminated data */
+		else
+		{	/* hand the text over without keeping a copy. Not on reload, where "sci-notify"
+			 * is connected and each piece would be reported to plugins */
+			set_text_from_buffer(doc->editor->sci, filedata.data, filedata.len);
+			filedata.data = NULL;
+		}
 		queue_colourise(doc);	/* Ensure the document gets colourised. */
 
-		/* detect & set line endings */
-		editor_mode = utils_get_line_endings(filedata.data, filedata.len);
+		/* set line endings, detected while loading */
+		editor_mode = filedata.eol_mode;
 		if (undo_reload_data)
 		{
 			undo_reload_data->eol_mode = editor_get_eol_char_mode(doc->editor);
@@ -1406,6 +2064,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		}
 
 		doc->priv->mtime = filedata.mtime; /* get the modification time from file and keep it */
+		doc->priv->disk_stamp = filedata.stamp;
 		g_free(doc->encoding);	/* if reloading, free old encoding */
 		doc->encoding = filedata.enc;
 		doc->has_bom = filedata.bom;
@@ -1426,7 +2085,16 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			g_signal_connect(doc->editor->sci, "sci-notify", G_CALLBACK(editor_sci_notify_cb),
 				doc->editor);
 
-			use_ft = (ft != NULL) ? ft : filetypes_detect_from_document(doc);
+			doc->priv->large_file = is_large_file(&filedata);
+			if (doc->priv->large_file)
+			{
+				/* keep an explicit filetype for when all features get enabled */
+				if (ft != NULL && ft->id != GEANY_FILETYPES_NONE)
+					doc->priv->large_file_ft = ft;
+				use_ft = filetypes[GEANY_FILETYPES_NONE];
+			}
+			else
+				use_ft = (ft != NULL) ? ft : filetypes_detect_from_document(doc);
 		}
 		else
 		{	/* reloading */
@@ -1461,6 +2129,10 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 			use_ft = ft;
 		}
+		/* let indentation detection use what was gathered while loading the text */
+		if (! reload)
+			doc->priv->indent_stats = &filedata.indent_stats;
+
 		/* update taglist, typedef keywords and build menu if necessary */
 		document_set_filetype(doc, use_ft);
 
@@ -1469,6 +2141,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			editor_set_indent(doc->editor, doc->editor->indent_type, doc->editor->indent_width); /* resetup sci */
 		else
 			document_apply_indent_settings(doc);
+		doc->priv->indent_stats = NULL;
 
 		document_set_text_changed(doc, FALSE);	/* also updates tab state */
 		ui_document_show_hide(doc);	/* update the document menu */
@@ -1495,6 +2168,9 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 		/* now the document is fully ready, display it (see notebook_new_tab()) */
 		gtk_widget_show(document_get_notebook_child(doc));
+
+		if (! reload && doc->priv->large_file)
+			show_large_file_message(doc);
 	}
 
 	g_free(display_filename);
@@ -1519,6 +2195,7 @@ void document_open_file_list(const gchar *data, gsize length)
 {
 	guint i;
 	gchar **list;
+	GSList *filenames = NULL;
 
 	g_return_if_fail(data != NULL);
 
@@ -1531,10 +2208,13 @@ void document_open_file_list(const gchar *data, gsize length)
 
 		if (filename == NULL)
 			continue;
-		document_open_file(filename, FALSE, NULL, NULL);
-		g_free(filename);
+		filenames = g_slist_prepend(filenames, filename);
 	}
+	filenames = g_slist_reverse(filenames);
+	document_open_files_async(filenames, FALSE, NULL, NULL);
 
+	g_slist_foreach(filenames, (GFunc) g_free, NULL);
+	g_slist_free(filenames);
 	g_strfreev(list);
 }
 
@@ -1554,10 +2234,97 @@ void document_open_files(const GSList *filenames, gboolean readonly, GeanyFilety
 {
 	const GSList *item;
 
+	/* read the files in the background while the documents are being set up */
+	for (item = filenames; item != NULL; item = g_slist_next(item))
+		document_prefetch_file(item->data, forced_enc);
+
 	for (item = filenames; item != NULL; item = g_slist_next(item))
 	{
 		document_open_file(item->data, readonly, ft, forced_enc);
 	}
+	document_prefetch_cancel();
+}
+
+
+static void open_request_free(gpointer data)
+{
+	OpenRequest *request = data;
+
+	g_free(request->locale_filename);
+	g_free(request->forced_enc);
+	g_free(request);
+}
+
+
+/* Opens the files at the head of open_queue whose contents have been read. */
+static gboolean open_queued_files(gpointer data)
+{
+	if (main_status.quitting)
+		return FALSE;
+
+	while (! g_queue_is_empty(&open_queue))
+	{
+		OpenRequest *request = g_queue_peek_head(&open_queue);
+		PrefetchJob *job = g_hash_table_lookup(prefetch_jobs, request->locale_filename);
+
+		/* keep the order of the files, the worker calls us again when this one is read */
+		if (job != NULL && prefetch_job_pending(job))
+		{
+			ui_set_statusbar(FALSE, _("Opening \"%s\"... (press Escape to cancel)"),
+				job->display_filename);
+			break;
+		}
+		g_queue_pop_head(&open_queue);
+		document_open_file(request->locale_filename, request->readonly, request->ft,
+			request->forced_enc);
+		open_request_free(request);
+	}
+	return FALSE;
+}
+
+
+/* Drops the files queued by document_open_files_async() that have not been opened yet.
+ * Returns: FALSE if there were none. */
+gboolean document_cancel_queued_opens(void)
+{
+	OpenRequest *request;
+
+	if (g_queue_is_empty(&open_queue))
+		return FALSE;
+
+	while ((request = g_queue_pop_head(&open_queue)) != NULL)
+	{
+		/* the worker stops after a running read */
+		g_hash_table_remove(prefetch_jobs, request->locale_filename);
+		open_request_free(request);
+	}
+	ui_set_statusbar(FALSE, _("Opening files cancelled."));
+	return TRUE;
+}
+
+
+/* Like document_open_files(), but returns right away. The files are read on worker threads
+ * and each is opened from the main loop once it and the files before it have been read,
+ * so that a large file or one on a slow file system doesn't block the UI in the meantime. */
+void document_open_files_async(const GSList *filenames, gboolean readonly, GeanyFiletype *ft,
+		const gchar *forced_enc)
+{
+	const GSList *item;
+
+	for (item = filenames; item != NULL; item = g_slist_next(item))
+	{
+		OpenRequest *request = g_new0(OpenRequest, 1);
+
+		prefetch_file(item->data, forced_enc, TRUE);
+
+		request->locale_filename = get_open_locale_filename(item->data);
+		request->readonly = readonly;
+		request->ft = ft;
+		request->forced_enc = g_strdup(forced_enc);
+		g_queue_push_tail(&open_queue, request);
+	}
+	/* open the files that were already open or are read already */
+	open_queued_files(NULL);
 }
 
 
@@ -2205,6 +2972,8 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 	if (! main_status.quitting)
 	{
 		sci_set_savepoint(doc->editor->sci);
+		if (! tm_source_file_get_stamp(locale_filename, &doc->priv->disk_stamp))
+			doc->priv->disk_stamp.mtime = -1;
 
 		if (file_prefs.disk_check_timeout > 0)
 			document_update_timestamp(doc, locale_filename);
@@ -2631,22 +3400,20 @@ gint document_replace_all(GeanyDocument *doc, const gchar *find_text, const gcha
 }
 
 
-/*
- * Parses or re-parses the document's buffer and updates the type
- * keywords and symbol list.
- *
- * @param doc The document.
- */
-void document_update_tags(GeanyDocument *doc)
+/* Parses or re-parses the document's buffer. Unless force is set, the type
+ * keywords and symbol list are only updated when the tags actually changed. */
+static void update_tags(GeanyDocument *doc, gboolean force)
 {
 	guchar *buffer_ptr;
 	gsize len;
+	TMTagsChange change;
 
 	g_return_if_fail(DOC_VALID(doc));
 	g_return_if_fail(app->tm_workspace != NULL);
 
 	/* early out if it's a new file or doesn't support tags */
-	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type))
+	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type) ||
+		doc->priv->large_file)
 	{
 		/* We must call sidebar_update_tag_list() before returning,
 		 * to ensure that the symbol list is always updated properly (e.g.
@@ -2660,11 +3427,29 @@ void document_update_tags(GeanyDocument *doc)
 	{
 		gchar *locale_filename = utils_get_locale_from_utf8(doc->file_name);
 		const gchar *name;
+		gboolean same_as_disk;
 
 		/* lookup the name rather than using filetype name to support custom filetypes */
 		name = tm_source_file_get_lang_name(doc->file_type->lang);
 		doc->tm_file = tm_source_file_new(locale_filename, name);
+		force = TRUE;
+
+		/* Right after opening, the buffer of an UTF-8 file without BOM is
+		 * identical to the file on disk - let TM parse the file itself then so
+		 * the tags can come from its tags cache. The TM file is also created
+		 * again later, e.g. when the filetype changes, so make sure the file
+		 * wasn't modified on disk since it was read or saved. */
+		same_as_disk = doc->tm_file && ! doc->changed && ! doc->has_bom &&
+			utils_str_equal(doc->encoding, "UTF-8") &&
+			file_unchanged_on_disk(doc, locale_filename);
 		g_free(locale_filename);
+		if (same_as_disk)
+		{
+			tm_workspace_add_source_file(doc->tm_file);
+			sidebar_update_tag_list(doc, TRUE);
+			document_highlight_tags(doc);
+			return;
+		}
 
 		if (doc->tm_file)
 			tm_workspace_add_source_file_noupdate(doc->tm_file);
@@ -2684,10 +3469,31 @@ void document_update_tags(GeanyDocument *doc)
 	 * Note: this buffer *MUST NOT* be modified */
 	len = sci_get_length(doc->editor->sci);
 	buffer_ptr = (guchar *) scintilla_send_message(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
-	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	change = tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+
+	/* e.g. edits inside a function body don't change any symbol */
+	if (! force && change == TM_TAGS_UNCHANGED)
+	{
+		sidebar_update_tag_list(doc, FALSE);
+		return;
+	}
 
 	sidebar_update_tag_list(doc, TRUE);
-	document_highlight_tags(doc);
+	/* type keywords don't depend on lines */
+	if (force || change == TM_TAGS_CHANGED)
+		document_highlight_tags(doc);
+}
+
+
+/*
+ * Parses or re-parses the document's buffer and updates the type
+ * keywords and symbol list.
+ *
+ * @param doc The document.
+ */
+void document_update_tags(GeanyDocument *doc)
+{
+	update_tags(doc, TRUE);
 }
 
 
@@ -2753,7 +3559,7 @@ static gboolean on_document_update_tag_list_idle(gpointer data)
 		return FALSE;
 
 	if (! main_status.quitting)
-		document_update_tags(doc);
+		update_tags(doc, FALSE);
 
 	doc->priv->tag_list_update_source = 0;
 
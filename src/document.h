@@ -66,6 +66,8 @@ typedef struct GeanyFilePrefs
 	gboolean		tab_close_switch_to_mru;
 	gboolean		keep_edit_history_on_reload; /* Keep undo stack upon, and allow undoing of, document reloading. */
 	gboolean		show_keep_edit_history_on_reload_msg; /* whether to show the message introducing the above feature */
+	gint			large_file_size;	/* size in MiB from which files are opened in large file mode, 0 to disable */
+	gint			large_file_line_length;	/* same for the length of the longest line */
 }
 GeanyFilePrefs;
 
@@ -262,6 +264,17 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 void document_open_file_list(const gchar *data, gsize length);
 
+void document_open_files_async(const GSList *filenames, gboolean readonly, GeanyFiletype *ft,
+		const gchar *forced_enc);
+
+gboolean document_cancel_queued_opens(void);
+
+void document_prefetch_file(const gchar *filename, const gchar *forced_enc);
+
+void document_prefetch_cancel(void);
+
+void document_leave_large_file_mode(GeanyDocument *doc);
+
 gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolean inc,
 		gboolean backwards);
 
@@ -67,10 +67,31 @@ enum
 	MSG_TYPE_RELOAD,
 	MSG_TYPE_RESAVE,
 	MSG_TYPE_POST_RELOAD,
+	MSG_TYPE_LARGE_FILE,
 
 	NUM_MSG_TYPES
 };
 
+/* largest tab and indent width IndentStats keep track of */
+#define INDENT_STATS_MAX_WIDTH 16
+
+/* Indentation statistics gathered in the same single pass over a file as its line endings
+ * while loading it, so that detecting its indentation doesn't need to scan it again */
+typedef struct IndentStats
+{
+	gsize	lines;
+	/* lines starting with a tab, resp. 2 spaces, by the largest tab width (up to
+	 * INDENT_STATS_MAX_WIDTH) for which they are indented by at most 24 columns */
+	gsize	tab_lines[INDENT_STATS_MAX_WIDTH + 1];
+	gsize	space_lines[INDENT_STATS_MAX_WIDTH + 1];
+	/* lines starting with tabs then as many spaces as the index, followed by a non-space */
+	gsize	mixed_lines[INDENT_STATS_MAX_WIDTH + 1];
+	/* lines with an indentation of 2 to 24 columns using 8 columns tabs, not starting with
+	 * an asterisk, that is a multiple of index + 2 */
+	gsize	widths[7];
+}
+IndentStats;
+
 /* Private GeanyDocument fields */
 typedef struct GeanyDocumentPrivate
 {
@@ -104,6 +125,8 @@ typedef struct GeanyDocumentPrivate
 	time_t			 last_check;
 	/* Modification time of the document on disk, only used when legacy file monitoring is used. */
 	time_t			 mtime;
+	/* State of the file on disk when it was last read or saved, mtime is -1 when unknown */
+	TMFileStamp		 disk_stamp;
 	/* ID of the idle callback updating the tag list */
 	guint			 tag_list_update_source;
 	/* Whether it's temporarily protected (read-only and saving needs confirmation). Does
@@ -111,6 +134,14 @@ typedef struct GeanyDocumentPrivate
 	gint			 protected;
 	/* Save pointer to info bars allowing to cancel them programatically (to avoid multiple ones) */
 	GtkWidget		*info_bars[NUM_MSG_TYPES];
+	/* Statistics of the text loaded from disk, only set while the document is being opened */
+	const IndentStats *indent_stats;
+	/* Whether the file was too large to enable highlighting, symbols, brace matching and
+	 * document word completion when it was opened, until document_leave_large_file_mode() */
+	gboolean		 large_file;
+	/* Filetype asked for when opening a large file, set by document_open_file_full()
+	 * and applied by document_leave_large_file_mode() */
+	GeanyFiletype	*large_file_ft;
 }
 GeanyDocumentPrivate;
 
@@ -599,7 +599,9 @@ static void check_line_breaking(GeanyEditor *editor, gint pos)
 }
 
 
-static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words)
+/* ranked is set when the words are ordered by relevance rather than sorted, and don't
+ * all start with the root, see tm_workspace_find_completions() */
+static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words, gboolean ranked)
 {
 	/* hide autocompletion if only option is already typed */
 	if (rootlen >= words->len ||
@@ -610,11 +612,25 @@ static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *word
 	}
 	/* store whether a calltip is showing, so we can reshow it after autocompletion */
 	calltip.set = (gboolean) SSM(sci, SCI_CALLTIPACTIVE, 0, 0);
+	/* keep the ranking and don't hide the list when no word starts with the root */
+	SSM(sci, SCI_AUTOCSETORDER, ranked ? SC_ORDER_CUSTOM : SC_ORDER_PRESORTED, 0);
+	SSM(sci, SCI_AUTOCSETIGNORECASE, ranked, 0);
+	SSM(sci, SCI_AUTOCSETAUTOHIDE, ! ranked, 0);
 	SSM(sci, SCI_AUTOCSHOW, rootlen, (sptr_t) words->str);
+
+	/* select the best match if none starts with the root */
+	if (ranked && SSM(sci, SCI_AUTOCGETCURRENT, 0, 0) < 0)
+	{
+		gchar *first = g_strndup(words->str, strcspn(words->str, "?\n"));
+
+		SSM(sci, SCI_AUTOCSELECT, 0, (sptr_t) first);
+		g_free(first);
+	}
 }
 
 
-static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen)
+static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen,
+		gboolean ranked)
 {
 	ScintillaObject *sci = editor->sci;
 
@@ -645,7 +661,7 @@ static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize roo
 			else
 				g_string_append(words, "?1");
 		}
-		show_autocomplete(sci, rootlen, words);
+		show_autocomplete(sci, rootlen, words, ranked);
 		g_string_free(words, TRUE);
 	}
 }
@@ -796,7 +812,7 @@ static gboolean autocomplete_scope(GeanyEditor *editor, const gchar *root, gsize
 
 		if (filtered->len > 0)
 		{
-			show_tags_list(editor, filtered, rootlen);
+			show_tags_list(editor, filtered, rootlen, FALSE);
 			ret = TRUE;
 		}
 
@@ -1166,6 +1182,11 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 			 * if they were showing */
 			autocomplete_scope_shown = FALSE;
 			request_reshowing_calltip(nt);
+			/* restore what show_autocomplete() changed for ranked lists, plugins'
+			 * user lists expect the defaults */
+			SSM(sci, SCI_AUTOCSETORDER, SC_ORDER_PRESORTED, 0);
+			SSM(sci, SCI_AUTOCSETIGNORECASE, FALSE, 0);
+			SSM(sci, SCI_AUTOCSETAUTOHIDE, TRUE, 0);
 			break;
 		case SCN_NEEDSHOWN:
 			ensure_range_visible(sci, nt->position, nt->position + nt->length, FALSE);
@@ -2085,10 +2106,10 @@ autocomplete_tags(GeanyEditor *editor, GeanyFiletype *ft, const gchar *root, gsi
 
 	g_return_val_if_fail(editor, FALSE);
 
-	tags = tm_workspace_find_prefix(root, ft->lang, editor_prefs.autocompletion_max_entries);
+	tags = tm_workspace_find_completions(root, ft->lang, editor_prefs.autocompletion_max_entries);
 	found = tags->len > 0;
 	if (found)
-		show_tags_list(editor, tags, rootlen);
+		show_tags_list(editor, tags, rootlen, TRUE);
 	g_ptr_array_free(tags, TRUE);
 
 	return found;
@@ -2215,7 +2236,7 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 
 	g_slist_free(words);
 
-	show_autocomplete(sci, rootlen, str);
+	show_autocomplete(sci, rootlen, str, FALSE);
 	g_string_free(str, TRUE);
 	return TRUE;
 }
@@ -2301,7 +2322,8 @@ gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean forc
 					ret = autocomplete_tags(editor, editor->document->file_type, root, rootlen);
 
 				/* If forcing and there's nothing else to show, complete from words in document */
-				if (!ret && (force || editor_prefs.autocomplete_doc_words))
+				if (!ret && (force || editor_prefs.autocomplete_doc_words) &&
+					! editor->document->priv->large_file)
 					ret = autocomplete_doc_word(editor, root, rootlen);
 			}
 		}
@@ -3442,6 +3464,10 @@ static void editor_highlight_braces(GeanyEditor *editor, gint cur_pos)
 	SSM(editor->sci, SCI_SETHIGHLIGHTGUIDE, 0, 0);
 	SSM(editor->sci, SCI_BRACEBADLIGHT, (uptr_t)-1, 0);
 
+	/* the matching brace could be anywhere in the document */
+	if (editor->document->priv->large_file)
+		return;
+
 	if (! utils_isbrace(sci_get_char_at(editor->sci, brace_pos), editor_prefs.brace_match_ltgt))
 	{
 		brace_pos++;
@@ -4761,7 +4787,9 @@ static gboolean editor_check_colourise(GeanyEditor *editor)
 		return FALSE;
 
 	doc->priv->colourise_needed = FALSE;
-	sci_colourise(editor->sci, 0, -1);
+	/* in large file mode, leave it to Scintilla to only style what gets displayed */
+	if (! doc->priv->large_file)
+		sci_colourise(editor->sci, 0, -1);
 
 	/* now that the current document is colourised, fold points are now accurate,
 	 * so force an update of the current function/tag. */
@@ -52,6 +52,9 @@
 /* " geany_encoding=utf-8 " or " coding: utf-8 " */
 #define PATTERN_CODING "coding[\t ]*[:=][\t ]*\"?([a-z0-9-]+)\"?[\t ]*"
 
+/* number of bytes a charset is tried on before converting a whole buffer from it */
+#define DETECTION_SAMPLE_SIZE 65536
+
 /* precompiled regexps */
 static GRegex *pregs[2];
 static gboolean pregs_loaded = FALSE;
@@ -610,6 +613,55 @@ void encodings_encoding_store_cell_data_func(GtkCellLayout *cell_layout,
 }
 
 
+/* Same as g_utf8_validate(buffer, size, NULL), but checks runs of ASCII characters 8 bytes
+ * at a time, as most of the text usually is ASCII */
+static gboolean utf8_validate(const gchar *buffer, gsize size)
+{
+	const gchar *p = buffer;
+	const gchar *end = buffer + size;
+
+	while (end - p >= (gssize) sizeof(guint64))
+	{
+		guint64 word;
+
+		memcpy(&word, p, sizeof word);
+		/* stop at the first word with a non-ASCII or a nul byte */
+		if ((word & G_GUINT64_CONSTANT(0x8080808080808080)) ||
+			((word - G_GUINT64_CONSTANT(0x0101010101010101)) & G_GUINT64_CONSTANT(0x8080808080808080)))
+			break;
+		p += sizeof word;
+	}
+
+	return g_utf8_validate(p, end - p, NULL);
+}
+
+
+/* Checks whether the start of buffer converts from charset into valid UTF-8. This is a lot
+ * cheaper than converting all of a large buffer just to find it is not in charset. */
+static gboolean sample_converts_from_charset(const gchar *buffer, gsize size, const gchar *charset)
+{
+	GError *conv_error = NULL;
+	gchar *converted_contents;
+	gsize bytes_written;
+	gboolean valid;
+
+	converted_contents = g_convert(buffer, MIN(size, DETECTION_SAMPLE_SIZE), "UTF-8", charset,
+		NULL, &bytes_written, &conv_error);
+
+	if (conv_error != NULL)
+	{
+		/* the sample can end in the middle of a character */
+		valid = g_error_matches(conv_error, G_CONVERT_ERROR, G_CONVERT_ERROR_PARTIAL_INPUT);
+		g_error_free(conv_error);
+	}
+	else
+		valid = utf8_validate(converted_contents, bytes_written);
+
+	g_free(converted_contents);
+	return valid;
+}
+
+
 /**
  *  Tries to convert @a buffer into UTF-8 encoding from the encoding specified with @a charset.
  *  If @a fast is not set, additional checks to validate the converted string are performed.
@@ -642,7 +694,7 @@ gchar *encodings_convert_to_utf8_from_charset(const gchar *buffer, gssize size,
 		utf8_content = converted_contents;
 		if (conv_error != NULL) g_error_free(conv_error);
 	}
-	else if (conv_error != NULL || ! g_utf8_validate(converted_contents, bytes_written, NULL))
+	else if (conv_error != NULL || ! utf8_validate(converted_contents, bytes_written))
 	{
 		if (conv_error != NULL)
 		{
@@ -689,6 +741,7 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 	gchar *utf8_content;
 	gboolean check_suggestion = suggested_charset != NULL;
 	gboolean check_locale = FALSE;
+	gint is_utf8 = -1;	/* whether buffer is valid UTF-8, -1 until checked */
 	gint i, preferred_charset;
 
 	if (size == -1)
@@ -749,7 +802,21 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 
 		geany_debug("Trying to convert %" G_GSIZE_FORMAT " bytes of data from %s into UTF-8.",
 			size, charset);
-		utf8_content = encodings_convert_to_utf8_from_charset(buffer, size, charset, FALSE);
+		if (encodings_get_idx_from_charset(charset) == GEANY_ENCODING_UTF_8)
+		{
+			/* no conversion needed, only validate the data, and only once */
+			if (is_utf8 < 0)
+				is_utf8 = utf8_validate(buffer, size);
+			utf8_content = is_utf8 ? g_strndup(buffer, size) : NULL;
+		}
+		else if (size > DETECTION_SAMPLE_SIZE &&
+			! sample_converts_from_charset(buffer, size, charset))
+		{
+			geany_debug("Couldn't convert the start of the data from %s to UTF-8.", charset);
+			utf8_content = NULL;
+		}
+		else
+			utf8_content = encodings_convert_to_utf8_from_charset(buffer, size, charset, FALSE);
 
 		if (G_LIKELY(utf8_content != NULL))
 		{
@@ -883,7 +950,7 @@ handle_forced_encoding(BufferData *buffer, const gchar *forced_enc)
 
 	if (utils_str_equal(forced_enc, "UTF-8"))
 	{
-		if (! g_utf8_validate(buffer->data, buffer->len, NULL))
+		if (! utf8_validate(buffer->data, buffer->len))
 		{
 			return FALSE;
 		}
@@ -955,7 +1022,7 @@ handle_encoding(BufferData *buffer, GeanyEncodingIndex enc_idx)
 
 			/* try UTF-8 first */
 			if (encodings_get_idx_from_charset(regex_charset) == GEANY_ENCODING_UTF_8 &&
-				(buffer->size == buffer->len) && g_utf8_validate(buffer->data, buffer->len, NULL))
+				(buffer->size == buffer->len) && utf8_validate(buffer->data, buffer->len))
 			{
 				buffer->enc = g_strdup("UTF-8");
 			}
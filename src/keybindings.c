@@ -1364,6 +1364,9 @@ static gboolean on_key_press_event(GtkWidget *widget, GdkEventKey *ev, gpointer
 #endif
 	if (check_menu_key(doc, keyval, state, ev->time))
 		return TRUE;
+	/* Escape drops the files still waiting to be opened, see document_open_files_async() */
+	if (keyval == GDK_Escape && state == 0 && document_cancel_queued_opens())
+		return TRUE;
 
 	foreach_ptr_array(group, g, keybinding_groups)
 	{
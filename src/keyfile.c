@@ -37,6 +37,7 @@
 #include "app.h"
 #include "build.h"
 #include "document.h"
+#include "documentprivate.h"
 #include "encodings.h"
 #include "encodingsprivate.h"
 #include "filetypes.h"
@@ -95,6 +96,8 @@
 #define GEANY_DEFAULT_TOOLS_PRINTCMD	"lpr"
 #define GEANY_DEFAULT_TOOLS_GREP		"grep"
 #define GEANY_DEFAULT_MRU_LENGTH		10
+#define GEANY_DEFAULT_LARGE_FILE_SIZE	50
+#define GEANY_DEFAULT_LARGE_FILE_LINE_LENGTH	50000
 #define GEANY_TOGGLE_MARK				"~ "
 #define GEANY_MAX_AUTOCOMPLETE_WORDS	30
 #define GEANY_MAX_SYMBOLS_UPDATE_FREQ	250
@@ -246,6 +249,10 @@ static void init_pref_groups(void)
 		"keep_edit_history_on_reload", TRUE);
 	stash_group_add_boolean(group, &file_prefs.show_keep_edit_history_on_reload_msg,
 		"show_keep_edit_history_on_reload_msg", TRUE);
+	stash_group_add_integer(group, &file_prefs.large_file_size,
+		"large_file_size", GEANY_DEFAULT_LARGE_FILE_SIZE);
+	stash_group_add_integer(group, &file_prefs.large_file_line_length,
+		"large_file_line_length", GEANY_DEFAULT_LARGE_FILE_LINE_LENGTH);
 	/* for backwards-compatibility */
 	stash_group_add_integer(group, &editor_prefs.indentation->hard_tab_width,
 		"indent_hard_tab_width", 8);
@@ -332,6 +339,10 @@ static gchar *get_session_file_string(GeanyDocument *doc)
 
 	if (ft == NULL) /* can happen when saving a new file when quitting */
 		ft = filetypes[GEANY_FILETYPES_NONE];
+	/* keep the filetype a document still in large file mode was opened with */
+	if (doc->priv->large_file && doc->priv->large_file_ft != NULL &&
+		ft->id == GEANY_FILETYPES_NONE)
+		ft = doc->priv->large_file_ft;
 
 	locale_filename = utils_get_locale_from_utf8(doc->file_name);
 	escaped_filename = g_uri_escape_string(locale_filename, NULL, TRUE);
@@ -1150,6 +1161,28 @@ gboolean configuration_load(void)
 }
 
 
+static const gchar *get_session_file_encoding(gchar **tmp)
+{
+	if (isdigit(tmp[3][0]))
+		return encodings_get_charset_from_index(atoi(tmp[3]));
+	else
+		return &(tmp[3][1]);
+}
+
+
+/* start reading a session file in the background, see document_prefetch_file() */
+static void prefetch_session_file(gchar **tmp)
+{
+	gchar *unescaped_filename = g_uri_unescape_string(tmp[7], NULL);
+	gchar *locale_filename = utils_get_locale_from_utf8(unescaped_filename);
+
+	document_prefetch_file(locale_filename, get_session_file_encoding(tmp));
+
+	g_free(locale_filename);
+	g_free(unescaped_filename);
+}
+
+
 static gboolean open_session_file(gchar **tmp, guint len)
 {
 	guint pos;
@@ -1166,14 +1199,7 @@ static gboolean open_session_file(gchar **tmp, guint len)
 	pos = atoi(tmp[0]);
 	ft_name = tmp[1];
 	ro = atoi(tmp[2]);
-	if (isdigit(tmp[3][0]))
-	{
-		encoding = encodings_get_charset_from_index(atoi(tmp[3]));
-	}
-	else
-	{
-		encoding = &(tmp[3][1]);
-	}
+	encoding = get_session_file_encoding(tmp);
 	indent_type = atoi(tmp[4]);
 	auto_indent = atoi(tmp[5]);
 	line_wrapping = atoi(tmp[6]);
@@ -1225,6 +1251,16 @@ void configuration_open_files(void)
 	/* necessary to set it to TRUE for project session support */
 	main_status.opening_session_files = TRUE;
 
+	/* read the files in the background while the documents are being set up */
+	for (i = 0; i < (gint)session_files->len; i++)
+	{
+		gchar **tmp = g_ptr_array_index(session_files,
+			file_prefs.tab_order_ltr ? i : (gint)session_files->len - 1 - i);
+
+		if (tmp != NULL && g_strv_length(tmp) >= 8)
+			prefetch_session_file(tmp);
+	}
+
 	i = file_prefs.tab_order_ltr ? 0 : (session_files->len - 1);
 	while (TRUE)
 	{
@@ -1254,6 +1290,7 @@ void configuration_open_files(void)
 
 	g_ptr_array_free(session_files, TRUE);
 	session_files = NULL;
+	document_prefetch_cancel();
 
 	if (failure)
 		ui_set_statusbar(TRUE, _("Failed to load one or more session files."));
@@ -105,6 +105,9 @@ static gchar *lib_vte = NULL;
 #endif
 static gboolean generate_tags = FALSE;
 static gboolean no_preprocessing = FALSE;
+static gboolean binary_tags = FALSE;
+static gint generate_tags_jobs = 1;
+static gboolean generate_tags_cache = FALSE;
 static gboolean ft_names = FALSE;
 static gboolean print_prefix = FALSE;
 #ifdef HAVE_PLUGINS
@@ -115,6 +118,8 @@ static gboolean dummy = FALSE;
 /* in alphabetical order of short options */
 static GOptionEntry entries[] =
 {
+	{ "binary-tags", 0, 0, G_OPTION_ARG_NONE, &binary_tags, N_("Generate a binary tags file (faster to load, use with --generate-tags)"), NULL },
+	{ "cache-tags", 0, 0, G_OPTION_ARG_NONE, &generate_tags_cache, N_("Reuse the tags of unchanged headers from previous runs (use with --generate-tags)"), NULL },
 	{ "column", 0, 0, G_OPTION_ARG_INT, &cl_options.goto_column, N_("Set initial column number for the first opened file (useful in conjunction with --line)"), NULL },
 	{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &alternate_config, N_("Use an alternate configuration directory"), NULL },
 	{ "ft-names", 0, 0, G_OPTION_ARG_NONE, &ft_names, N_("Print internal filetype names"), NULL },
@@ -125,6 +130,7 @@ static GOptionEntry entries[] =
 	{ "socket-file", 0, 0, G_OPTION_ARG_FILENAME, &cl_options.socket_filename, N_("Use this socket filename for communication with a running Geany instance"), NULL },
 	{ "list-documents", 0, 0, G_OPTION_ARG_NONE, &cl_options.list_documents, N_("Return a list of open documents in a running Geany instance"), NULL },
 #endif
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &generate_tags_jobs, N_("Number of parallel jobs when generating tags file"), N_("N") },
 	{ "line", 'l', 0, G_OPTION_ARG_INT, &cl_options.goto_line, N_("Set initial line number for the first opened file"), NULL },
 	{ "no-msgwin", 'm', 0, G_OPTION_ARG_NONE, &no_msgwin, N_("Don't show message window at startup"), NULL },
 	{ "no-ctags", 'n', 0, G_OPTION_ARG_NONE, &ignore_global_tags, N_("Don't load auto completion data (see documentation)"), NULL },
@@ -590,7 +596,8 @@ static void parse_command_line_options(gint *argc, gchar ***argv)
 		gboolean ret;
 
 		filetypes_init_types();
-		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing);
+		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing, binary_tags,
+			generate_tags_jobs, generate_tags_cache);
 		filetypes_free_types();
 		wait_for_input_on_windows();
 		exit(ret);
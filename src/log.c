@@ -41,6 +41,8 @@
 #endif
 
 static GString *log_buffer = NULL;
+static GMutex log_mutex;	/* protects log_buffer, messages may come from worker threads */
+static GThread *main_thread = NULL;
 static GtkTextBuffer *dialog_textbuffer = NULL;
 
 enum
@@ -49,14 +51,25 @@ enum
 };
 
 
+static gboolean update_dialog_idle(gpointer data);
+
+
 static void update_dialog(void)
 {
+	if (g_thread_self() != main_thread)
+	{	/* GTK can only be used from the main thread */
+		g_idle_add(update_dialog_idle, NULL);
+		return;
+	}
+
 	if (dialog_textbuffer != NULL)
 	{
 		GtkTextMark *mark;
 		GtkTextView *textview = g_object_get_data(G_OBJECT(dialog_textbuffer), "textview");
 
+		g_mutex_lock(&log_mutex);
 		gtk_text_buffer_set_text(dialog_textbuffer, log_buffer->str, log_buffer->len);
+		g_mutex_unlock(&log_mutex);
 		/* scroll to the end of the messages as this might be most interesting */
 		mark = gtk_text_buffer_get_insert(dialog_textbuffer);
 		gtk_text_view_scroll_to_mark(textview, mark, 0.0, FALSE, 0.0, 0.0);
@@ -64,6 +77,13 @@ static void update_dialog(void)
 }
 
 
+static gboolean update_dialog_idle(gpointer data)
+{
+	update_dialog();
+	return FALSE;
+}
+
+
 /* Geany's main debug/log function, declared in geany.h */
 void geany_debug(gchar const *format, ...)
 {
@@ -79,7 +99,9 @@ static void handler_print(const gchar *msg)
 	printf("%s\n", msg);
 	if (G_LIKELY(log_buffer != NULL))
 	{
+		g_mutex_lock(&log_mutex);
 		g_string_append_printf(log_buffer, "%s\n", msg);
+		g_mutex_unlock(&log_mutex);
 		update_dialog();
 	}
 }
@@ -90,7 +112,9 @@ static void handler_printerr(const gchar *msg)
 	fprintf(stderr, "%s\n", msg);
 	if (G_LIKELY(log_buffer != NULL))
 	{
+		g_mutex_lock(&log_mutex);
 		g_string_append_printf(log_buffer, "%s\n", msg);
+		g_mutex_unlock(&log_mutex);
 		update_dialog();
 	}
 }
@@ -140,8 +164,10 @@ static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *
 
 	time_str = utils_get_current_time_string();
 
+	g_mutex_lock(&log_mutex);
 	g_string_append_printf(log_buffer, "%s: %s %s: %s\n", time_str, domain,
 		get_log_prefix(level), msg);
+	g_mutex_unlock(&log_mutex);
 
 	g_free(time_str);
 
@@ -152,6 +178,7 @@ static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *
 void log_handlers_init(void)
 {
 	log_buffer = g_string_sized_new(2048);
+	main_thread = g_thread_self();
 
 	g_set_print_handler(handler_print);
 	g_set_printerr_handler(handler_printerr);
@@ -169,7 +196,9 @@ static void on_dialog_response(GtkDialog *dialog, gint response, gpointer user_d
 		gtk_text_buffer_get_end_iter(dialog_textbuffer, &end_iter);
 		gtk_text_buffer_delete(dialog_textbuffer, &start_iter, &end_iter);
 
+		g_mutex_lock(&log_mutex);
 		g_string_erase(log_buffer, 0, -1);
+		g_mutex_unlock(&log_mutex);
 	}
 	else
 	{
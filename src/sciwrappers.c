@@ -749,6 +749,13 @@ void sci_clear_all(ScintillaObject *sci)
 }
 
 
+/* makes room for a text of bytes bytes without reallocating */
+void sci_allocate(ScintillaObject *sci, gint bytes)
+{
+	SSM(sci, SCI_ALLOCATE, (uptr_t) bytes, 0);
+}
+
+
 gint sci_get_end_styled(ScintillaObject *sci)
 {
 	return (gint) SSM(sci, SCI_GETENDSTYLED, 0, 0);
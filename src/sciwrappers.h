@@ -153,6 +153,7 @@ gboolean			sci_get_fold_expanded		(ScintillaObject *sci, gint line);
 
 void				sci_colourise				(ScintillaObject *sci, gint start, gint end);
 void				sci_clear_all				(ScintillaObject *sci);
+void				sci_allocate				(ScintillaObject *sci, gint bytes);
 gint				sci_get_end_styled			(ScintillaObject *sci);
 void				sci_set_tab_width			(ScintillaObject *sci, gint width);
 void				sci_set_savepoint			(ScintillaObject *sci);
@@ -51,6 +51,7 @@
 #include "sidebar.h"
 #include "support.h"
 #include "tm_parser.h"
+#include "tm_source_file.h"
 #include "tm_tag.h"
 #include "ui_utils.h"
 #include "utils.h"
@@ -118,8 +119,8 @@ symbol_menu;
 
 static void load_user_tags(GeanyFiletypeID ft_id);
 
-/* get the tags_ignore list, exported by tagmanager's options.c */
-extern gchar **c_tags_ignore;
+/* whether ignore.tags was read, see load_c_ignore_tags() */
+static gboolean c_ignore_tags_loaded = FALSE;
 
 /* ignore certain tokens when parsing C-like syntax.
  * Also works for reloading. */
@@ -130,12 +131,16 @@ static void load_c_ignore_tags(void)
 
 	if (g_file_get_contents(path, &content, NULL, NULL))
 	{
+		gchar **tags;
+
 		/* historically we ignore the glib _DECLS for tag generation */
 		SETPTR(content, g_strconcat("G_BEGIN_DECLS G_END_DECLS\n", content, NULL));
 
-		g_strfreev(c_tags_ignore);
-		c_tags_ignore = g_strsplit_set(content, " \n\r", -1);
+		tags = g_strsplit_set(content, " \n\r", -1);
+		tm_source_file_set_ignore_tags(tags);
+		g_strfreev(tags);
 		g_free(content);
+		c_ignore_tags_loaded = TRUE;
 	}
 	g_free(path);
 }
@@ -180,7 +185,7 @@ void symbols_global_tags_loaded(guint file_type_idx)
 {
 	/* load ignore list for C/C++ parser */
 	if ((file_type_idx == GEANY_FILETYPES_C || file_type_idx == GEANY_FILETYPES_CPP) &&
-		c_tags_ignore == NULL)
+		! c_ignore_tags_loaded)
 	{
 		load_c_ignore_tags();
 	}
@@ -1606,7 +1611,8 @@ static GeanyFiletype *detect_global_tags_filetype(const gchar *utf8_filename)
  * the relevant path.
  * Example:
  * CFLAGS=-I/home/user/libname-1.x geany -g libname.d.tags libname.h */
-int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess)
+int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess,
+		gboolean binary, gint jobs, gboolean use_cache)
 {
 	/* -E pre-process, -dD output user macros, -p prof info (?) */
 	const char pre_process[] = "gcc -E -dD -p -I.";
@@ -1644,12 +1650,20 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 		else
 			command = NULL;	/* don't preprocess */
 
+		if (use_cache)
+		{
+			gchar *cache_dir = g_build_filename(app->configdir, GEANY_TAGS_CACHE_SUBDIR, NULL);
+
+			tm_source_file_set_cache_dir(cache_dir);
+			g_free(cache_dir);
+		}
+
 		geany_debug("Generating %s tags file.", ft->name);
 		tm_get_workspace();
 		status = tm_workspace_create_global_tags(command, (const char **) (argv + 2),
-												 argc - 2, tags_file, ft->lang);
+												 argc - 2, tags_file, ft->lang, binary, MAX(jobs, 1), use_cache);
 		g_free(command);
-		symbols_finalize(); /* free c_tags_ignore data */
+		symbols_finalize(); /* free the ignore list */
 		if (! status)
 		{
 			g_printerr(_("Failed to create tags file, perhaps because no symbols "
@@ -2300,7 +2314,7 @@ static gint get_current_tag_name(GeanyDocument *doc, gchar **tagname, TMTagType
 	if (parent >= 0 && doc->tm_file != NULL && doc->tm_file->tags_array != NULL &&
 		(! doc->changed || editor_prefs.autocompletion_update_freq > 0))
 	{
-		const TMTag *tag = tm_get_current_tag(doc->tm_file->tags_array, parent + 1, tag_types);
+		const TMTag *tag = tm_source_file_get_current_tag(doc->tm_file, parent + 1, tag_types);
 
 		if (tag)
 		{
@@ -2595,6 +2609,11 @@ void symbols_init(void)
 
 	g_signal_connect(geany_object, "document-save", G_CALLBACK(on_document_save), NULL);
 
+	/* keep the tags of files unchanged on disk between sessions */
+	f = g_build_filename(app->configdir, GEANY_TAGS_CACHE_SUBDIR, NULL);
+	tm_source_file_set_cache_dir(f);
+	g_free(f);
+
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 		symbols_icons[i].pixbuf = get_tag_icon(symbols_icons[i].icon_name);
 }
@@ -2604,7 +2623,10 @@ void symbols_finalize(void)
 {
 	guint i;
 
-	g_strfreev(c_tags_ignore);
+	tm_source_file_set_ignore_tags(NULL);
+	c_ignore_tags_loaded = FALSE;
+	tm_source_file_prune_cache();
+	tm_source_file_set_cache_dir(NULL);
 
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 	{
@@ -22,6 +22,7 @@
 
 #include "general.h"
 #include "entry.h"
+#include "main.h"
 #include "parse.h"
 #include "read.h"
 
@@ -47,61 +48,71 @@ static gboolean parse_callback(const tagEntryInfo *tag, gpointer user_data)
 }
 
 
-void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType lang, TMCtagsNewTagCallback tag_callback,
-	TMCtagsPassStartCallback pass_callback, gpointer user_data)
+/* Parses the buffer or file described by ctx. This can be called from several
+ * threads at once; the ctags state of the parse lives in a parseContext on the
+ * stack and the parsers keep theirs in thread-local variables. The callbacks
+ * are invoked from the calling thread. */
+void tm_ctags_parse_ctx(const TMCtagsParseCtx *ctx)
 {
-	CallbackUserData callback_data = {tag_callback, user_data};
+	CallbackUserData callback_data;
+	parseContext context;
+	parserDefinition *def;
 	gboolean retry = TRUE;
 	guint passCount = 0;
 
-	g_return_if_fail(buffer || file_name);
+	g_return_if_fail(ctx != NULL);
+	g_return_if_fail(ctx->buffer || ctx->file_name);
 
-	if (! LanguageTable [lang]->enabled)
+	def = LanguageTable [ctx->lang];
+	if (! def->enabled)
 	{
 #ifdef TM_DEBUG
-		g_warning("ignoring %s (language disabled)\n", file_name);
+		g_warning("ignoring %s (language disabled)\n", ctx->file_name);
 #endif
 		return;
 	}
 
-	setTagEntryFunction(parse_callback, &callback_data);
+	callback_data.tag_callback = ctx->tag_callback;
+	callback_data.user_data = ctx->user_data;
+	beginParse(&context, parse_callback, &callback_data);
+	context.ignoreTokens = ctx->ignore_tags;
 	while (retry && passCount < 3)
 	{
-		pass_callback(user_data);
-		if (!buffer && fileOpen (file_name, lang))
+		ctx->pass_callback(ctx->user_data);
+		if (!ctx->buffer && fileOpen (ctx->file_name, ctx->lang))
 		{
-			if (LanguageTable [lang]->parser != NULL)
+			if (def->parser != NULL)
 			{
-				LanguageTable [lang]->parser ();
+				def->parser ();
 				fileClose ();
 				retry = FALSE;
 				break;
 			}
-			else if (LanguageTable [lang]->parser2 != NULL)
-				retry = LanguageTable [lang]->parser2 (passCount);
+			else if (def->parser2 != NULL)
+				retry = def->parser2 (passCount);
 			fileClose ();
 		}
-		else if (buffer && bufferOpen (buffer, buffer_size, file_name, lang))
+		else if (ctx->buffer && bufferOpen (ctx->buffer, ctx->buffer_size, ctx->file_name, ctx->lang))
 		{
-			if (LanguageTable [lang]->parser != NULL)
+			if (def->parser != NULL)
 			{
-				LanguageTable [lang]->parser ();
+				def->parser ();
 				bufferClose ();
 				retry = FALSE;
 				break;
 			}
-			else if (LanguageTable [lang]->parser2 != NULL)
-				retry = LanguageTable [lang]->parser2 (passCount);
+			else if (def->parser2 != NULL)
+				retry = def->parser2 (passCount);
 			bufferClose ();
 		}
 		else
 		{
-			g_warning("Unable to open %s", file_name);
-			return;
+			g_warning("Unable to open %s", ctx->file_name);
+			break;
 		}
 		++ passCount;
 	}
+	endParse();
 }
 
 
@@ -117,6 +128,13 @@ TMParserType tm_ctags_get_named_lang(const gchar *name)
 }
 
 
+/* Guesses the language of a file from its name, the way ctags does */
+TMParserType tm_ctags_get_file_lang(const gchar *file_name)
+{
+	return getFileLanguage(file_name);
+}
+
+
 const gchar *tm_ctags_get_lang_kinds(TMParserType lang)
 {
 	guint i;
@@ -169,3 +187,11 @@ guint tm_ctags_get_lang_count(void)
 {
 	return LanguageCount;
 }
+
+
+/* Returns the number of allocations made by the ctags code on the calling thread,
+ * the difference before and after a parse is what the parse allocated. */
+gulong tm_ctags_get_allocation_count(void)
+{
+	return getAllocationCount();
+}
@@ -39,17 +39,31 @@ typedef gboolean (*TMCtagsNewTagCallback) (const tagEntryInfo *const tag,
  * currently unused */
 typedef gboolean (*TMCtagsPassStartCallback) (void *user_data);
 
+/* Everything a single parse depends on. Either buffer or file_name must be
+ * set; when buffer is NULL, the file is read from disk. */
+typedef struct
+{
+	guchar *buffer;
+	gsize buffer_size;
+	const gchar *file_name;
+	TMParserType lang;
+	TMCtagsNewTagCallback tag_callback;
+	TMCtagsPassStartCallback pass_callback;
+	gpointer user_data;
+	gchar **ignore_tags;	/* tokens the C-based parsers skip, can be NULL */
+} TMCtagsParseCtx;
+
 
 void tm_ctags_init(void);
 
-void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType lang, TMCtagsNewTagCallback tag_callback,
-	TMCtagsPassStartCallback pass_callback, gpointer user_data);
+void tm_ctags_parse_ctx(const TMCtagsParseCtx *ctx);
 
 const gchar *tm_ctags_get_lang_name(TMParserType lang);
 
 TMParserType tm_ctags_get_named_lang(const gchar *name);
 
+TMParserType tm_ctags_get_file_lang(const gchar *file_name);
+
 const gchar *tm_ctags_get_lang_kinds(TMParserType lang);
 
 const gchar *tm_ctags_get_kind_name(gchar kind, TMParserType lang);
@@ -60,6 +74,8 @@ gboolean tm_ctags_is_using_regex_parser(TMParserType lang);
 
 guint tm_ctags_get_lang_count(void);
 
+gulong tm_ctags_get_allocation_count(void);
+
 G_END_DECLS
 
 #endif /* TM_CTAGS_WRAPPERS */
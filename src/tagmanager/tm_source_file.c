@@ -13,6 +13,7 @@
  tags for individual files.
 */
 
+#include "general.h"	/* for VERSION */
 
 #include <stdio.h>
 #include <limits.h>
@@ -36,6 +37,14 @@ typedef struct
 {
 	TMSourceFile public;
 	guint refcount;
+	/* state of the file on disk when it was last read, the key of the tags
+	 * cache entry (stamp.mtime is -1 when unknown) */
+	TMFileStamp stamp;
+	GPtrArray *cached_tags; /* tags read from the cache, not yet used by a parse */
+	/* tag type mask -> the tags of that type sorted by line, for
+	 * tm_source_file_get_current_tag(); built on demand from line_index_tags */
+	GHashTable *line_index;
+	GPtrArray *line_index_tags;
 } TMSourceFilePriv;
 
 
@@ -45,6 +54,38 @@ typedef enum {
 	TM_FILE_FORMAT_CTAGS
 } TMFileFormat;
 
+/* Binary tags files start with this line, followed by a BinaryTagsHeader,
+ * tag_count BinaryTagRecords and the string table. All numbers are in the
+ * byte order of the machine which generated the file. */
+#define BINARY_TAGS_FORMAT_LINE "# format=binary\n"
+#define BINARY_TAGS_BYTE_ORDER 0x01020304
+#define BINARY_TAGS_VERSION 1
+
+typedef struct
+{
+	guint32 byte_order;
+	guint32 version;
+	guint32 tag_count;
+	guint32 strings_size;
+} BinaryTagsHeader;
+
+/* strings are offsets into the string table, 0 meaning NULL */
+typedef struct
+{
+	guint32 name;
+	guint32 arglist;
+	guint32 scope;
+	guint32 inheritance;
+	guint32 var_type;
+	guint32 type;
+	guint32 line;
+	guint32 pointer_order;
+	guint8 local;
+	gchar access;
+	gchar impl;
+	guint8 padding;
+} BinaryTagRecord;
+
 /* Note: To preserve binary compatibility, it is very important
 	that you only *append* to this list ! */
 enum
@@ -70,6 +111,29 @@ enum
 #define SOURCE_FILE_NEW(S) ((S) = g_slice_new(TMSourceFilePriv))
 #define SOURCE_FILE_FREE(S) g_slice_free(TMSourceFilePriv, (TMSourceFilePriv *) S)
 
+/* Bump when the layout of the tags cache files changes */
+#define TAGS_CACHE_FORMAT 3
+#define TAGS_CACHE_MAGIC "TMCACHE"
+
+/* Limits of the tags cache, see tm_source_file_prune_cache() */
+#define TAGS_CACHE_MAX_AGE (30 * 24 * 60 * 60)	/* seconds */
+#define TAGS_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+/* Directory of the tags cache, NULL when caching is disabled */
+static gchar *tags_cache_dir = NULL;
+
+/* Tokens skipped by the C-based parsers, see tm_source_file_set_ignore_tags().
+ * Parses use a copy as the list can be replaced while they run in other threads. */
+static gchar **ignore_tags = NULL;
+static GMutex ignore_tags_mutex;
+
+typedef struct
+{
+	const gchar *pos;
+	const gchar *end;
+} TagsCacheReader;
+
+
 static int get_path_max(const char *path)
 {
 #ifdef PATH_MAX
@@ -192,11 +256,11 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const tagEntryInfo *tag
 		tag->arglist = g_strdup(tag_entry->extensionFields.arglist);
 	if ((NULL != tag_entry->extensionFields.scope[1]) &&
 		(0 != tag_entry->extensionFields.scope[1][0]))
-		tag->scope = g_strdup(tag_entry->extensionFields.scope[1]);
+		tag->scope = tm_tag_intern_string(tag_entry->extensionFields.scope[1]);
 	if (tag_entry->extensionFields.inheritance != NULL)
-		tag->inheritance = g_strdup(tag_entry->extensionFields.inheritance);
+		tag->inheritance = tm_tag_intern_string(tag_entry->extensionFields.inheritance);
 	if (tag_entry->extensionFields.varType != NULL)
-		tag->var_type = g_strdup(tag_entry->extensionFields.varType);
+		tag->var_type = tm_tag_intern_string(tag_entry->extensionFields.varType);
 	if (tag_entry->extensionFields.access != NULL)
 		tag->access = get_tag_access(tag_entry->extensionFields.access);
 	if (tag_entry->extensionFields.implementation != NULL)
@@ -258,16 +322,16 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 					tag->arglist = g_strdup((gchar*)start + 1);
 					break;
 				case TA_SCOPE:
-					tag->scope = g_strdup((gchar*)start + 1);
+					tag->scope = tm_tag_intern_string((gchar*)start + 1);
 					break;
 				case TA_POINTER:
 					tag->pointerOrder = atoi((gchar*)start + 1);
 					break;
 				case TA_VARTYPE:
-					tag->var_type = g_strdup((gchar*)start + 1);
+					tag->var_type = tm_tag_intern_string((gchar*)start + 1);
 					break;
 				case TA_INHERITS:
-					tag->inheritance = g_strdup((gchar*)start + 1);
+					tag->inheritance = tm_tag_intern_string((gchar*)start + 1);
 					break;
 				case TA_TIME:  /* Obsolete */
 					break;
@@ -327,7 +391,7 @@ static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
 
 			if (field_len >= 1) tag->name = g_strdup(fields[0]);
 			else tag->name = NULL;
-			if (field_len >= 2 && fields[1] != NULL) tag->var_type = g_strdup(fields[1]);
+			if (field_len >= 2 && fields[1] != NULL) tag->var_type = tm_tag_intern_string(fields[1]);
 			if (field_len >= 3 && fields[2] != NULL) tag->arglist = g_strdup(fields[2]);
 			tag->type = tm_tag_prototype_t;
 			g_strfreev(fields);
@@ -423,8 +487,8 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 			}
 			else if (0 == strcmp(key, "inherits")) /* comma-separated list of classes this class inherits from */
 			{
-				g_free(tag->inheritance);
-				tag->inheritance = g_strdup(value);
+				tm_tag_release_string(tag->inheritance);
+				tag->inheritance = tm_tag_intern_string(value);
 			}
 			else if (0 == strcmp(key, "implementation")) /* implementation limit */
 				tag->impl = get_tag_impl(value);
@@ -438,8 +502,8 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 					 0 == strcmp(key, "struct") ||
 					 0 == strcmp(key, "union")) /* Name of the class/enum/function/struct/union in which this tag is a member */
 			{
-				g_free(tag->scope);
-				tag->scope = g_strdup(value);
+				tm_tag_release_string(tag->scope);
+				tag->scope = tm_tag_intern_string(value);
 			}
 			else if (0 == strcmp(key, "file")) /* static (local) tag */
 				tag->local = TRUE;
@@ -519,6 +583,114 @@ static gboolean write_tag(TMTag *tag, FILE *fp, TMTagAttrType attrs)
 		return FALSE;
 }
 
+static const gchar *binary_tags_get_string(const gchar *strings, guint32 strings_size,
+	guint32 offset, gboolean *valid)
+{
+	if (offset >= strings_size)
+	{
+		*valid = FALSE;
+		return NULL;
+	}
+	return offset ? strings + offset : NULL;
+}
+
+/* Fills in tag, the strings it doesn't intern are left in the mapped file */
+static gboolean init_tag_from_binary_record(TMTag *tag, const BinaryTagRecord *record,
+	const gchar *strings, guint32 strings_size, TMParserType mode)
+{
+	gboolean valid = TRUE;
+	const gchar *name, *arglist, *scope, *inheritance, *var_type;
+
+	name = binary_tags_get_string(strings, strings_size, record->name, &valid);
+	arglist = binary_tags_get_string(strings, strings_size, record->arglist, &valid);
+	scope = binary_tags_get_string(strings, strings_size, record->scope, &valid);
+	inheritance = binary_tags_get_string(strings, strings_size, record->inheritance, &valid);
+	var_type = binary_tags_get_string(strings, strings_size, record->var_type, &valid);
+	if (!valid || !name)
+		return FALSE;
+
+	tag->name = (gchar *) name;
+	tag->arglist = (gchar *) arglist;
+	tag->scope = tm_tag_intern_string(scope);
+	tag->inheritance = tm_tag_intern_string(inheritance);
+	tag->var_type = tm_tag_intern_string(var_type);
+	tag->type = record->type;
+	tag->line = record->line;
+	tag->pointerOrder = record->pointer_order;
+	tag->local = record->local;
+	tag->access = record->access;
+	tag->impl = record->impl;
+	tag->lang = mode;
+	return TRUE;
+}
+
+/* Reads a binary tags file written by tm_source_file_write_binary_tags_file().
+ The file is mapped to memory and its fixed-size records are converted to tags
+ without any text parsing. The tags are allocated at once, and their names and
+ argument lists point into the mapping, which is kept until they are all freed. */
+static GPtrArray *read_binary_tags_file(const gchar *tags_file, TMParserType mode)
+{
+	const gsize format_len = strlen(BINARY_TAGS_FORMAT_LINE);
+	BinaryTagsHeader header;
+	const BinaryTagRecord *records;
+	const gchar *contents, *strings;
+	GPtrArray *file_tags = NULL;
+	TMTag *tags;
+	GMappedFile *map;
+	gsize length;
+	guint32 i;
+
+	map = g_mapped_file_new(tags_file, FALSE, NULL);
+	if (!map)
+		return NULL;
+
+	contents = g_mapped_file_get_contents(map);
+	length = g_mapped_file_get_length(map);
+	if (length < format_len + sizeof(header))
+		goto out;
+
+	memcpy(&header, contents + format_len, sizeof(header));
+	length -= format_len + sizeof(header);
+	if (header.byte_order != BINARY_TAGS_BYTE_ORDER || header.version != BINARY_TAGS_VERSION)
+	{
+		g_warning("%s: unsupported binary tags file (generated on a different "
+			"platform or by a different version)", tags_file);
+		goto out;
+	}
+	if (header.tag_count > length / sizeof(BinaryTagRecord) ||
+		header.strings_size == 0 ||
+		header.strings_size != length - header.tag_count * sizeof(BinaryTagRecord))
+		goto out;
+
+	/* the header line and BinaryTagsHeader keep the records 4-byte aligned */
+	records = (const BinaryTagRecord *) (contents + format_len + sizeof(header));
+	strings = (const gchar *) (records + header.tag_count);
+	if (strings[header.strings_size - 1] != '\0')
+		goto out;
+
+	file_tags = g_ptr_array_sized_new(header.tag_count);
+	if (header.tag_count == 0)
+		goto out;
+
+	tags = tm_tags_new_in_arena(header.tag_count, g_mapped_file_ref(map),
+		(GDestroyNotify) g_mapped_file_unref);
+	for (i = 0; i < header.tag_count; i++)
+		g_ptr_array_add(file_tags, &tags[i]);
+	for (i = 0; i < header.tag_count; i++)
+	{
+		if (!init_tag_from_binary_record(&tags[i], &records[i], strings, header.strings_size, mode))
+		{
+			tm_tags_array_free(file_tags, TRUE);
+			file_tags = NULL;
+			break;
+		}
+	}
+
+out:
+	g_mapped_file_unref(map);
+	return file_tags;
+}
+
 GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode)
 {
 	guchar buf[BUFSIZ];
@@ -536,7 +708,12 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 	}
 	else
 	{	/* We read the first line for the format specification. */
-		if (buf[0] == '#' && strstr((gchar*) buf, "format=pipe") != NULL)
+		if (strcmp((gchar*) buf, BINARY_TAGS_FORMAT_LINE) == 0)
+		{
+			fclose(fp);
+			return read_binary_tags_file(tags_file, mode);
+		}
+		else if (buf[0] == '#' && strstr((gchar*) buf, "format=pipe") != NULL)
 			format = TM_FILE_FORMAT_PIPE;
 		else if (buf[0] == '#' && strstr((gchar*) buf, "format=tagmanager") != NULL)
 			format = TM_FILE_FORMAT_TAGMANAGER;
@@ -601,6 +778,613 @@ gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_
 	return ret;
 }
 
+/* Sets the directory where the tags of files parsed from disk are cached
+ between sessions, or NULL to disable the cache */
+void tm_source_file_set_cache_dir(const gchar *cache_dir)
+{
+	g_free(tags_cache_dir);
+	tags_cache_dir = g_strdup(cache_dir);
+}
+
+/* cache entries are named after the checksum of their key */
+static gchar *get_tags_cache_path(const gchar *key)
+{
+	gchar *checksum, *path;
+
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5, key, -1);
+	path = g_build_filename(tags_cache_dir, checksum, NULL);
+	g_free(checksum);
+
+	return path;
+}
+
+/* Sets the tokens the C-based parsers should skip, see the -I option of ctags.
+ @param tags NULL-terminated array of tokens, copied. Can be NULL. */
+void tm_source_file_set_ignore_tags(gchar **tags)
+{
+	g_mutex_lock(&ignore_tags_mutex);
+	g_strfreev(ignore_tags);
+	ignore_tags = g_strdupv(tags);
+	g_mutex_unlock(&ignore_tags_mutex);
+}
+
+/* returns a copy of the current ignore list, to free with g_strfreev() */
+static gchar **get_ignore_tags(void)
+{
+	gchar **tags;
+
+	g_mutex_lock(&ignore_tags_mutex);
+	tags = g_strdupv(ignore_tags);
+	g_mutex_unlock(&ignore_tags_mutex);
+
+	return tags;
+}
+
+/* the C-based parsers skip the tokens of the ignore list so the tags depend on it */
+static gchar *get_tags_cache_ignore_list(gchar **tags)
+{
+	return tags ? g_strjoinv(" ", tags) : g_strdup("");
+}
+
+static void cache_write_data(GByteArray *buf, gconstpointer data, gsize size)
+{
+	g_byte_array_append(buf, data, size);
+}
+
+static void cache_write_uint(GByteArray *buf, guint32 val)
+{
+	cache_write_data(buf, &val, sizeof(val));
+}
+
+static void cache_write_int64(GByteArray *buf, gint64 val)
+{
+	cache_write_data(buf, &val, sizeof(val));
+}
+
+/* strings are stored with their length + 1, 0 meaning NULL */
+static void cache_write_string(GByteArray *buf, const gchar *str)
+{
+	guint32 len = str ? strlen(str) : 0;
+
+	cache_write_uint(buf, str ? len + 1 : 0);
+	if (str)
+		cache_write_data(buf, str, len);
+}
+
+static gboolean cache_read_data(TagsCacheReader *reader, gpointer data, gsize size)
+{
+	if ((gsize) (reader->end - reader->pos) < size)
+		return FALSE;
+
+	memcpy(data, reader->pos, size);
+	reader->pos += size;
+	return TRUE;
+}
+
+static gboolean cache_read_uint(TagsCacheReader *reader, guint32 *val)
+{
+	return cache_read_data(reader, val, sizeof(*val));
+}
+
+static gboolean cache_read_int64(TagsCacheReader *reader, gint64 *val)
+{
+	return cache_read_data(reader, val, sizeof(*val));
+}
+
+static gboolean cache_read_string(TagsCacheReader *reader, gchar **str)
+{
+	guint32 len;
+
+	*str = NULL;
+	if (!cache_read_uint(reader, &len))
+		return FALSE;
+	if (len == 0)
+		return TRUE;
+	if ((gsize) (reader->end - reader->pos) < len - 1)
+		return FALSE;
+
+	*str = g_strndup(reader->pos, len - 1);
+	reader->pos += len - 1;
+	return TRUE;
+}
+
+/* reads a string shared between tags, see tm_tag_intern_string() */
+static gboolean cache_read_interned_string(TagsCacheReader *reader, gchar **str)
+{
+	gchar *tmp;
+
+	if (!cache_read_string(reader, &tmp))
+		return FALSE;
+	*str = tm_tag_intern_string(tmp);
+	g_free(tmp);
+	return TRUE;
+}
+
+/* reads a string and checks it's equal to expected */
+static gboolean cache_check_string(TagsCacheReader *reader, const gchar *expected)
+{
+	gchar *str;
+	gboolean ret;
+
+	ret = cache_read_string(reader, &str) && g_strcmp0(str, expected) == 0;
+	g_free(str);
+	return ret;
+}
+
+static gboolean cache_read_tag(TagsCacheReader *reader, TMTag *tag)
+{
+	guint32 type, pointer_order;
+	gint64 line;
+	gchar local, access, impl;
+
+	if (!cache_read_string(reader, &tag->name) || !tag->name ||
+		!cache_read_uint(reader, &type) ||
+		!cache_read_int64(reader, &line) ||
+		!cache_read_data(reader, &local, 1) ||
+		!cache_read_uint(reader, &pointer_order) ||
+		!cache_read_string(reader, &tag->arglist) ||
+		!cache_read_interned_string(reader, &tag->scope) ||
+		!cache_read_interned_string(reader, &tag->inheritance) ||
+		!cache_read_interned_string(reader, &tag->var_type) ||
+		!cache_read_data(reader, &access, 1) ||
+		!cache_read_data(reader, &impl, 1))
+		return FALSE;
+
+	tag->type = type;
+	tag->line = line;
+	tag->local = local;
+	tag->pointerOrder = pointer_order;
+	tag->access = access;
+	tag->impl = impl;
+	return TRUE;
+}
+
+static void cache_write_tag(GByteArray *buf, const TMTag *tag)
+{
+	gchar local = tag->local;
+
+	cache_write_string(buf, tag->name);
+	cache_write_uint(buf, tag->type);
+	cache_write_int64(buf, tag->line);
+	cache_write_data(buf, &local, 1);
+	cache_write_uint(buf, tag->pointerOrder);
+	cache_write_string(buf, tag->arglist);
+	cache_write_string(buf, tag->scope);
+	cache_write_string(buf, tag->inheritance);
+	cache_write_string(buf, tag->var_type);
+	cache_write_data(buf, &tag->access, 1);
+	cache_write_data(buf, &tag->impl, 1);
+}
+
+/* Gets the state of file_name on disk, to tell whether it changed */
+gboolean tm_source_file_get_stamp(const gchar *file_name, TMFileStamp *stamp)
+{
+	GStatBuf st;
+
+	if (g_stat(file_name, &st) != 0)
+		return FALSE;
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	stamp->mtime = (gint64) st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+	stamp->ctime = (gint64) st.st_ctim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_ctim.tv_nsec;
+#else
+	stamp->mtime = (gint64) st.st_mtime * G_GINT64_CONSTANT(1000000000);
+	stamp->ctime = (gint64) st.st_ctime * G_GINT64_CONSTANT(1000000000);
+#endif
+	stamp->size = st.st_size;
+	stamp->inode = st.st_ino;
+	return TRUE;
+}
+
+static void cache_write_file_stamp(GByteArray *buf, const TMFileStamp *stamp)
+{
+	cache_write_int64(buf, stamp->mtime);
+	cache_write_int64(buf, stamp->ctime);
+	cache_write_int64(buf, stamp->size);
+	cache_write_int64(buf, stamp->inode);
+}
+
+/* reads a file stamp and checks it's equal to expected */
+static gboolean cache_check_file_stamp(TagsCacheReader *reader, const TMFileStamp *expected)
+{
+	TMFileStamp stamp;
+
+	return cache_read_int64(reader, &stamp.mtime) && stamp.mtime == expected->mtime &&
+		cache_read_int64(reader, &stamp.ctime) && stamp.ctime == expected->ctime &&
+		cache_read_int64(reader, &stamp.size) && stamp.size == expected->size &&
+		cache_read_int64(reader, &stamp.inode) && stamp.inode == expected->inode;
+}
+
+/* Every cache entry starts with the settings its tags depend on and its key.
+ tags is the ignore list the tags were parsed with. */
+static void cache_write_header(GByteArray *buf, const gchar *key, TMParserType lang,
+	gchar **tags)
+{
+	gchar *ignore_list = get_tags_cache_ignore_list(tags);
+
+	cache_write_data(buf, TAGS_CACHE_MAGIC, sizeof(TAGS_CACHE_MAGIC));
+	cache_write_uint(buf, TAGS_CACHE_FORMAT);
+	cache_write_string(buf, VERSION);
+	cache_write_string(buf, tm_source_file_get_lang_name(lang));
+	cache_write_string(buf, ignore_list);
+	cache_write_string(buf, key);
+	g_free(ignore_list);
+}
+
+/* Loads the cache entry of key and checks its header matches the current
+ settings, leaving reader after the header.
+ @return The entry contents to free with g_free(), or NULL if there is no
+ usable entry. */
+static gchar *cache_read_header(const gchar *key, TMParserType lang, TagsCacheReader *reader)
+{
+	gchar magic[sizeof(TAGS_CACHE_MAGIC)];
+	gchar *path, *contents, *ignore_list;
+	gchar **tags;
+	gsize length;
+	guint32 format;
+	gboolean valid;
+
+	if (!tags_cache_dir)
+		return NULL;
+
+	path = get_tags_cache_path(key);
+	valid = g_file_get_contents(path, &contents, &length, NULL);
+	g_free(path);
+	if (!valid)
+		return NULL;
+
+	reader->pos = contents;
+	reader->end = contents + length;
+	tags = get_ignore_tags();
+	ignore_list = get_tags_cache_ignore_list(tags);
+	g_strfreev(tags);
+	valid = cache_read_data(reader, magic, sizeof(magic)) &&
+		memcmp(magic, TAGS_CACHE_MAGIC, sizeof(magic)) == 0 &&
+		cache_read_uint(reader, &format) && format == TAGS_CACHE_FORMAT &&
+		cache_check_string(reader, VERSION) &&
+		cache_check_string(reader, tm_source_file_get_lang_name(lang)) &&
+		cache_check_string(reader, ignore_list) &&
+		cache_check_string(reader, key);
+	g_free(ignore_list);
+
+	if (!valid)
+	{
+		g_free(contents);
+		return NULL;
+	}
+	return contents;
+}
+
+static void cache_write_tags(GByteArray *buf, GPtrArray *tags_array)
+{
+	guint i;
+
+	cache_write_uint(buf, tags_array->len);
+	for (i = 0; i < tags_array->len; i++)
+		cache_write_tag(buf, tags_array->pdata[i]);
+}
+
+/* reads the tags at the end of a cache entry, attributing them to source_file */
+static GPtrArray *cache_read_tags(TagsCacheReader *reader, TMSourceFile *source_file)
+{
+	GPtrArray *tags;
+	guint32 count, i;
+	gboolean valid = TRUE;
+
+	if (!cache_read_uint(reader, &count))
+		return NULL;
+
+	tags = g_ptr_array_sized_new(count);
+	for (i = 0; i < count && valid; i++)
+	{
+		TMTag *tag = tm_tag_new();
+
+		valid = cache_read_tag(reader, tag);
+		tag->file = source_file;
+		tag->lang = source_file->lang;
+		g_ptr_array_add(tags, tag);
+	}
+	if (!valid)
+	{
+		tm_tags_array_free(tags, TRUE);
+		tags = NULL;
+	}
+	return tags;
+}
+
+/* stores the cache entry buf under key */
+static void cache_write_entry(const gchar *key, GByteArray *buf)
+{
+	gchar *path = get_tags_cache_path(key);
+
+	if (!g_file_set_contents(path, (gchar *) buf->data, buf->len, NULL))
+		g_warning("Unable to write tags cache %s", path);
+	g_free(path);
+}
+
+/* Reads the tags of source_file from its cache entry if the entry was created
+ from the file in its current state on disk. Can be called from any thread.
+ @return The cached tags or NULL if there is no up-to-date cache entry. */
+static GPtrArray *read_tags_cache(TMSourceFile *source_file)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+	TagsCacheReader reader;
+	GPtrArray *tags = NULL;
+	gchar *contents;
+
+	if (priv->stamp.mtime < 0)
+		return NULL;
+
+	contents = cache_read_header(source_file->file_name, source_file->lang, &reader);
+	if (!contents)
+		return NULL;
+
+	if (cache_check_file_stamp(&reader, &priv->stamp))
+		tags = cache_read_tags(&reader, source_file);
+
+	g_free(contents);
+	return tags;
+}
+
+/* Stores the tags of source_file, parsed with the ignore list tags, in its cache entry */
+static void write_tags_cache(TMSourceFile *source_file, gchar **tags)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+	GByteArray *buf;
+
+	if (!tags_cache_dir || priv->stamp.mtime < 0)
+		return;
+
+	if (g_mkdir_with_parents(tags_cache_dir, 0700) != 0)
+		return;
+
+	buf = g_byte_array_new();
+	cache_write_header(buf, source_file->file_name, source_file->lang, tags);
+	cache_write_file_stamp(buf, &priv->stamp);
+	cache_write_tags(buf, source_file->tags_array);
+
+	cache_write_entry(source_file->file_name, buf);
+	g_byte_array_free(buf, TRUE);
+}
+
+/* Reads the tags stored by tm_source_file_write_header_cache() under key, if
+ none of the files they were generated from changed since. The tags are
+ attributed to source_file. Can be called from any thread.
+ @return The cached tags or NULL if there is no up-to-date cache entry. */
+GPtrArray *tm_source_file_read_header_cache(const gchar *key, TMSourceFile *source_file)
+{
+	TagsCacheReader reader;
+	GPtrArray *tags = NULL;
+	gchar *contents;
+	guint32 count, i;
+	gboolean valid;
+
+	contents = cache_read_header(key, source_file->lang, &reader);
+	if (!contents)
+		return NULL;
+
+	/* the files the tags came from, with their state at the time */
+	valid = cache_read_uint(&reader, &count);
+	for (i = 0; i < count && valid; i++)
+	{
+		gchar *file_name = NULL;
+		TMFileStamp stamp;
+
+		valid = cache_read_string(&reader, &file_name) && file_name &&
+			tm_source_file_get_stamp(file_name, &stamp) &&
+			cache_check_file_stamp(&reader, &stamp);
+		g_free(file_name);
+	}
+
+	if (valid)
+		tags = cache_read_tags(&reader, source_file);
+
+	g_free(contents);
+	return tags;
+}
+
+/* Stores the tags of source_file in the cache under key, along with the state
+ of the files in dependencies they were generated from. Used to avoid
+ preprocessing and parsing the same headers when generating global tags. */
+void tm_source_file_write_header_cache(const gchar *key, GPtrArray *dependencies,
+	TMSourceFile *source_file)
+{
+	GByteArray *buf;
+	gchar **tags;
+	guint i;
+
+	if (!tags_cache_dir || g_mkdir_with_parents(tags_cache_dir, 0700) != 0)
+		return;
+
+	buf = g_byte_array_new();
+	tags = get_ignore_tags();
+	cache_write_header(buf, key, source_file->lang, tags);
+	g_strfreev(tags);
+
+	cache_write_uint(buf, dependencies->len);
+	for (i = 0; i < dependencies->len; i++)
+	{
+		const gchar *file_name = dependencies->pdata[i];
+		TMFileStamp stamp;
+
+		if (!tm_source_file_get_stamp(file_name, &stamp))
+		{
+			/* can't tell when it changes, so don't cache */
+			g_byte_array_free(buf, TRUE);
+			return;
+		}
+		cache_write_string(buf, file_name);
+		cache_write_file_stamp(buf, &stamp);
+	}
+
+	cache_write_tags(buf, source_file->tags_array);
+
+	cache_write_entry(key, buf);
+	g_byte_array_free(buf, TRUE);
+}
+
+typedef struct
+{
+	gchar *path;
+	gint64 mtime;
+	gint64 size;
+} TagsCacheEntry;
+
+static void tags_cache_entry_free(gpointer data)
+{
+	TagsCacheEntry *entry = data;
+
+	g_free(entry->path);
+	g_free(entry);
+}
+
+static gint tags_cache_entry_compare(gconstpointer a, gconstpointer b)
+{
+	const TagsCacheEntry *e1 = *((const TagsCacheEntry **) a);
+	const TagsCacheEntry *e2 = *((const TagsCacheEntry **) b);
+
+	return (e1->mtime > e2->mtime) - (e1->mtime < e2->mtime);
+}
+
+/* Removes the tags cache entries older than TAGS_CACHE_MAX_AGE, then the
+ oldest ones until the cache is smaller than TAGS_CACHE_MAX_SIZE. Entries are
+ rewritten when their files change; the ones of files which don't change
+ expire too but are simply created again by their next parse. */
+void tm_source_file_prune_cache(void)
+{
+	GPtrArray *entries;
+	const gchar *name;
+	gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+	gint64 total = 0;
+	GDir *dir;
+	guint i;
+
+	if (!tags_cache_dir)
+		return;
+
+	dir = g_dir_open(tags_cache_dir, 0, NULL);
+	if (!dir)
+		return;
+
+	entries = g_ptr_array_new_with_free_func(tags_cache_entry_free);
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		gchar *path = g_build_filename(tags_cache_dir, name, NULL);
+		TagsCacheEntry *entry;
+		GStatBuf st;
+
+		if (g_stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+			g_free(path);
+		else if (now - st.st_mtime > TAGS_CACHE_MAX_AGE)
+		{
+			g_unlink(path);
+			g_free(path);
+		}
+		else
+		{
+			entry = g_new(TagsCacheEntry, 1);
+			entry->path = path;
+			entry->mtime = st.st_mtime;
+			entry->size = st.st_size;
+			g_ptr_array_add(entries, entry);
+			total += st.st_size;
+		}
+	}
+	g_dir_close(dir);
+
+	g_ptr_array_sort(entries, tags_cache_entry_compare);
+	for (i = 0; i < entries->len && total > TAGS_CACHE_MAX_SIZE; i++)
+	{
+		TagsCacheEntry *entry = entries->pdata[i];
+
+		g_unlink(entry->path);
+		total -= entry->size;
+	}
+	g_ptr_array_free(entries, TRUE);
+}
+
+/* returns the offset of str in the string table, adding it if needed */
+static guint32 binary_tags_add_string(GByteArray *strings, GHashTable *offsets, const gchar *str)
+{
+	gpointer offset;
+
+	if (!str)
+		return 0;
+
+	if (!g_hash_table_lookup_extended(offsets, str, NULL, &offset))
+	{
+		offset = GUINT_TO_POINTER(strings->len);
+		g_byte_array_append(strings, (const guint8 *) str, strlen(str) + 1);
+		g_hash_table_insert(offsets, (gpointer) str, offset);
+	}
+	return GPOINTER_TO_UINT(offset);
+}
+
+/* Writes tags_array to a binary tags file which can be loaded much faster than
+ the text formats. The file is only readable on machines with the same byte order.
+ @param tags_file The file to write.
+ @param tags_array The tags to write, sorted like the global tags.
+ @return TRUE on success, FALSE on failure. */
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array)
+{
+	BinaryTagsHeader header;
+	BinaryTagRecord *records;
+	GByteArray *strings;
+	GHashTable *offsets;
+	FILE *fp;
+	guint i;
+	gboolean ret;
+
+	g_return_val_if_fail(tags_array && tags_file, FALSE);
+
+	strings = g_byte_array_new();
+	offsets = g_hash_table_new(g_str_hash, g_str_equal);
+	/* offset 0 is reserved for NULL strings */
+	g_byte_array_append(strings, (const guint8 *) "", 1);
+
+	records = g_new0(BinaryTagRecord, tags_array->len);
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = TM_TAG(tags_array->pdata[i]);
+		BinaryTagRecord *record = &records[i];
+
+		record->name = binary_tags_add_string(strings, offsets, tag->name);
+		record->arglist = binary_tags_add_string(strings, offsets, tag->arglist);
+		record->scope = binary_tags_add_string(strings, offsets, tag->scope);
+		record->inheritance = binary_tags_add_string(strings, offsets, tag->inheritance);
+		record->var_type = binary_tags_add_string(strings, offsets, tag->var_type);
+		record->type = tag->type;
+		record->line = tag->line;
+		record->pointer_order = tag->pointerOrder;
+		record->local = tag->local;
+		record->access = tag->access;
+		record->impl = tag->impl;
+	}
+
+	header.byte_order = BINARY_TAGS_BYTE_ORDER;
+	header.version = BINARY_TAGS_VERSION;
+	header.tag_count = tags_array->len;
+	header.strings_size = strings->len;
+
+	fp = g_fopen(tags_file, "wb");
+	ret = (fp != NULL);
+	if (fp)
+	{
+		ret = fputs(BINARY_TAGS_FORMAT_LINE, fp) >= 0 &&
+			fwrite(&header, sizeof(header), 1, fp) == 1 &&
+			(tags_array->len == 0 ||
+				fwrite(records, sizeof(BinaryTagRecord), tags_array->len, fp) == tags_array->len) &&
+			fwrite(strings->data, strings->len, 1, fp) == 1;
+		ret = (fclose(fp) == 0) && ret;
+	}
+
+	g_free(records);
+	g_hash_table_destroy(offsets);
+	g_byte_array_free(strings, TRUE);
+
+	return ret;
+}
+
 /* add argument list of __init__() Python methods to the class tag */
 static void update_python_arglist(const TMTag *tag, TMSourceFile *current_source_file)
 {
@@ -720,6 +1504,10 @@ TMSourceFile *tm_source_file_new(const char *file_name, const char *name)
 		return NULL;
 	}
 	priv->refcount = 1;
+	priv->stamp.mtime = -1;
+	priv->cached_tags = NULL;
+	priv->line_index = NULL;
+	priv->line_index_tags = NULL;
 	return &priv->public;
 }
 
@@ -740,6 +1528,8 @@ static TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
 */
 static void tm_source_file_destroy(TMSourceFile *source_file)
 {
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
 #ifdef TM_DEBUG
 	g_message("Destroying source file: %s", source_file->file_name);
 #endif
@@ -747,6 +1537,11 @@ static void tm_source_file_destroy(TMSourceFile *source_file)
 	g_free(source_file->file_name);
 	tm_tags_array_free(source_file->tags_array, TRUE);
 	source_file->tags_array = NULL;
+	tm_tags_array_free(priv->cached_tags, TRUE);
+	priv->cached_tags = NULL;
+	if (priv->line_index)
+		g_hash_table_destroy(priv->line_index);
+	priv->line_index = NULL;
 }
 
 /** Decrements the reference count of @a source_file
@@ -769,6 +1564,101 @@ void tm_source_file_free(TMSourceFile *source_file)
 	}
 }
 
+static gint line_index_compare(gconstpointer a, gconstpointer b)
+{
+	const TMTag *t1 = *((const TMTag **) a);
+	const TMTag *t2 = *((const TMTag **) b);
+
+	return (t1->line > t2->line) - (t1->line < t2->line);
+}
+
+/* Returns the tags of source_file matching tag_types, sorted by line and, for
+ * tags on the same line, in the order of the tags array */
+static GPtrArray *get_line_index(TMSourceFile *source_file, TMTagType tag_types)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+	GPtrArray *index;
+	guint i;
+
+	if (priv->line_index && priv->line_index_tags != source_file->tags_array)
+	{
+		g_hash_table_destroy(priv->line_index);
+		priv->line_index = NULL;
+	}
+	if (!priv->line_index)
+	{
+		priv->line_index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+			(GDestroyNotify) g_ptr_array_unref);
+		priv->line_index_tags = source_file->tags_array;
+	}
+
+	index = g_hash_table_lookup(priv->line_index, GUINT_TO_POINTER(tag_types));
+	if (!index)
+	{
+		index = g_ptr_array_new();
+		for (i = 0; i < source_file->tags_array->len; i++)
+		{
+			TMTag *tag = source_file->tags_array->pdata[i];
+
+			if (tag && tag->type & tag_types)
+				g_ptr_array_add(index, tag);
+		}
+		/* stable since GLib 2.32 */
+		g_ptr_array_sort(index, line_index_compare);
+		g_hash_table_insert(priv->line_index, GUINT_TO_POINTER(tag_types), index);
+	}
+	return index;
+}
+
+/* returns the position of the first tag in index with a line greater than line */
+static guint line_index_upper_bound(const GPtrArray *index, gulong line)
+{
+	guint low = 0, high = index->len;
+
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+
+		if (TM_TAG(index->pdata[mid])->line <= line)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+/* Same as tm_get_current_tag() on the tags of source_file, but in logarithmic
+ time using a line index built on the first call after each parse.
+ @param source_file The source file.
+ @param line Current line in the file.
+ @param tag_types The tag types to include in the match.
+ @return The matching tag or NULL. */
+const TMTag *tm_source_file_get_current_tag(TMSourceFile *source_file, gulong line,
+	TMTagType tag_types)
+{
+	GPtrArray *index;
+	guint pos;
+	gulong tag_line;
+
+	g_return_val_if_fail(source_file != NULL, NULL);
+
+	if (!source_file->tags_array || !source_file->tags_array->len || line == 0)
+		return NULL;
+
+	index = get_line_index(source_file, tag_types);
+	pos = line_index_upper_bound(index, line);
+	if (pos == 0)
+		return NULL;
+
+	/* like tm_get_current_tag(), prefer the first tag of the array on that line */
+	tag_line = TM_TAG(index->pdata[pos - 1])->line;
+	if (tag_line == 0)
+		return NULL;
+	pos = line_index_upper_bound(index, tag_line - 1);
+
+	return index->pdata[pos];
+}
+
 /** Gets the GBoxed-derived GType for TMSourceFile
  *
  * @return TMSourceFile type . */
@@ -777,17 +1667,62 @@ GType tm_source_file_get_type(void);
 
 G_DEFINE_BOXED_TYPE(TMSourceFile, tm_source_file, tm_source_file_dup, tm_source_file_free);
 
+/* Loads the file of the source file to memory unless it is too big to be parsed
+ from memory or its tags can be taken from the tags cache. The loaded contents
+ can then be passed to tm_source_file_parse() with use_buffer set to FALSE. This
+ function only accesses source_file and can be called from any thread while
+ source_file isn't used elsewhere.
+ @param source_file The source file to load.
+ @param contents Return location for the file contents, set to NULL if the file
+ should be parsed directly from disk. Free with g_free().
+ @param length Return location for the length of contents.
+ @return TRUE on success, FALSE if the file could not be read.
+*/
+gboolean tm_source_file_read_contents(TMSourceFile *source_file, gchar **contents,
+	gsize *length)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	*contents = NULL;
+	*length = 0;
+	priv->stamp.mtime = -1;
+	tm_tags_array_free(priv->cached_tags, TRUE);
+	priv->cached_tags = NULL;
+
+	if (!tm_source_file_get_stamp(source_file->file_name, &priv->stamp))
+	{
+		priv->stamp.mtime = -1;
+		return TRUE;
+	}
+
+	/* up-to-date tags are in the cache, no need to read the file */
+	priv->cached_tags = read_tags_cache(source_file);
+	if (priv->cached_tags)
+		return TRUE;
+
+	/* load file to memory and parse it from memory unless the file is too big */
+	if (priv->stamp.size > 10*1024*1024)
+		return TRUE;
+
+	return g_file_get_contents(source_file->file_name, contents, length, NULL);
+}
+
 /* Parses the text-buffer or source file and regenarates the tags.
  @param source_file The source file to parse
  @param text_buf The text buffer to parse
  @param buf_size The size of text_buf.
- @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
- TRUE to parse the buffer and ignore the file content.
+ @param use_buffer Set FALSE to parse the file directly or TRUE to parse the buffer
+ and ignore the file content. When FALSE, text_buf is either NULL or holds the
+ file contents read by tm_source_file_read_contents(). Tags of files parsed from
+ disk are stored in the tags cache (see tm_source_file_set_cache_dir()).
  @return TRUE on success, FALSE on failure
 */
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
 	gboolean use_buffer)
 {
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+	TMCtagsParseCtx ctx;
+	gchar **tags;
 	const char *file_name;
 	gboolean retry = TRUE;
 	gboolean parse_file = FALSE;
@@ -798,6 +1733,13 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 		g_warning("Attempt to parse NULL file");
 		return FALSE;
 	}
+
+	/* the tags are about to change */
+	if (priv->line_index)
+	{
+		g_hash_table_destroy(priv->line_index);
+		priv->line_index = NULL;
+	}
 	
 	if (source_file->lang == TM_PARSER_NONE)
 	{
@@ -809,20 +1751,30 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	
 	if (!use_buffer)
 	{
-		GStatBuf s;
-		
-		/* load file to memory and parse it from memory unless the file is too big */
-		if (g_stat(file_name, &s) != 0 || s.st_size > 10*1024*1024)
-			parse_file = TRUE;
-		else
+		/* the file may have been read by tm_source_file_read_contents() already */
+		if (!text_buf && !priv->cached_tags)
 		{
-			if (!g_file_get_contents(file_name, (gchar**)&text_buf, (gsize*)&buf_size, NULL))
+			if (!tm_source_file_read_contents(source_file, (gchar**)&text_buf, &buf_size))
 			{
 				g_warning("Unable to open %s", file_name);
 				return FALSE;
 			}
-			free_buf = TRUE;
+			free_buf = (text_buf != NULL);
+		}
+
+		if (priv->cached_tags)
+		{
+			guint i;
+
+			tm_tags_array_free(source_file->tags_array, FALSE);
+			for (i = 0; i < priv->cached_tags->len; i++)
+				g_ptr_array_add(source_file->tags_array, priv->cached_tags->pdata[i]);
+			g_ptr_array_free(priv->cached_tags, TRUE);
+			priv->cached_tags = NULL;
+			return TRUE;
 		}
+
+		parse_file = (text_buf == NULL);
 	}
 
 	if (!parse_file && (NULL == text_buf || 0 == buf_size))
@@ -836,8 +1788,20 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 
 	tm_tags_array_free(source_file->tags_array, FALSE);
 
-	tm_ctags_parse(parse_file ? NULL : text_buf, buf_size, file_name,
-		source_file->lang, ctags_new_tag, ctags_pass_start, source_file);
+	tags = get_ignore_tags();
+	ctx.buffer = parse_file ? NULL : text_buf;
+	ctx.buffer_size = buf_size;
+	ctx.file_name = file_name;
+	ctx.lang = source_file->lang;
+	ctx.tag_callback = ctags_new_tag;
+	ctx.pass_callback = ctags_pass_start;
+	ctx.user_data = source_file;
+	ctx.ignore_tags = tags;
+	tm_ctags_parse_ctx(&ctx);
+
+	if (!use_buffer)
+		write_tags_cache(source_file, tags);
+	g_strfreev(tags);
 
 	if (free_buf)
 		g_free(text_buf);
@@ -46,6 +46,15 @@ gchar *tm_get_real_path(const gchar *file_name);
 
 #ifdef GEANY_PRIVATE
 
+/* State of a file on disk, times are in nanoseconds */
+typedef struct
+{
+	gint64 mtime;
+	gint64 ctime;	/* also catches files replaced keeping their mtime */
+	gint64 size;
+	gint64 inode;
+} TMFileStamp;
+
 const gchar *tm_source_file_get_lang_name(TMParserType lang);
 
 TMParserType tm_source_file_get_named_lang(const gchar *name);
@@ -53,10 +62,34 @@ TMParserType tm_source_file_get_named_lang(const gchar *name);
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
 	gboolean use_buffer);
 
+/* TMTag is declared in tm_tag.h, which includes this file */
+struct TMTag;
+
+const struct TMTag *tm_source_file_get_current_tag(TMSourceFile *source_file, gulong line,
+	TMTagType tag_types);
+
+gboolean tm_source_file_get_stamp(const gchar *file_name, TMFileStamp *stamp);
+
+void tm_source_file_set_cache_dir(const gchar *cache_dir);
+
+void tm_source_file_prune_cache(void);
+
+void tm_source_file_set_ignore_tags(gchar **tags);
+
+GPtrArray *tm_source_file_read_header_cache(const gchar *key, TMSourceFile *source_file);
+
+void tm_source_file_write_header_cache(const gchar *key, GPtrArray *dependencies,
+	TMSourceFile *source_file);
+
+gboolean tm_source_file_read_contents(TMSourceFile *source_file, gchar **contents,
+	gsize *length);
+
 GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode);
 
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array);
 
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -8,6 +8,7 @@
 */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <glib-object.h>
 
@@ -82,6 +83,22 @@ typedef struct
 	gboolean first;
 } TMSortOptions;
 
+/* Entry of the interned strings pool. The string is allocated together with
+ * its reference count so releasing it doesn't need a hash table lookup. */
+typedef struct
+{
+	guint refcount;
+	gchar str[];
+} TMInternedString;
+
+#define INTERNED_STRING(s) \
+	((TMInternedString *) (void *) ((s) - offsetof(TMInternedString, str)))
+
+/* Pool of the scope, inheritance and var_type strings shared between all
+ * tags. Tags are created from the loading threads as well, hence the lock. */
+static GHashTable *interned_strings = NULL;
+static GMutex interned_strings_mutex;
+
 /* Gets the GType for a TMTag */
 GType tm_tag_get_type(void)
 {
@@ -108,6 +125,113 @@ TMTag *tm_tag_new(void)
 	return tag;
 }
 
+struct TMTagArena
+{
+	gint refcount; /* the number of tags of the arena still alive */
+	gpointer data;
+	GDestroyNotify data_free;
+};
+
+/*
+ Creates @a count tags in a single allocation, for loading many tags at once.
+ Their name and arglist are not freed with them, so they can point into
+ @a data, which is freed with @a data_free once all the tags have been
+ unreferenced. Their scope, inheritance and var_type are interned as usual.
+ @param count The number of tags, greater than 0.
+ @return The first of the @a count new tags, each with a reference count of 1.
+*/
+TMTag *tm_tags_new_in_arena(guint count, gpointer data, GDestroyNotify data_free)
+{
+	TMTagArena *arena;
+	TMTag *tags;
+	guint i;
+
+	g_return_val_if_fail(count > 0, NULL);
+
+	arena = g_malloc0(sizeof(TMTagArena) + count * sizeof(TMTag));
+	arena->refcount = (gint) count;
+	arena->data = data;
+	arena->data_free = data_free;
+
+	tags = (TMTag *) (arena + 1);
+	for (i = 0; i < count; i++)
+	{
+		tags[i].refcount = 1;
+		tags[i].arena = arena;
+	}
+	return tags;
+}
+
+static void tm_tag_arena_unref(TMTagArena *arena)
+{
+	if (g_atomic_int_dec_and_test(&arena->refcount))
+	{
+		if (arena->data_free)
+			arena->data_free(arena->data);
+		g_free(arena);
+	}
+}
+
+/*
+ Returns a shared copy of @a str. The same pointer is returned for equal
+ strings, so the result must never be modified and has to be released with
+ tm_tag_release_string() rather than g_free().
+ Used for the scope, inheritance and var_type fields of TMTag which repeat
+ a lot across the workspace.
+ @param str The string to intern, can be NULL.
+ @return The interned string, or NULL if @a str is NULL.
+*/
+gchar *tm_tag_intern_string(const gchar *str)
+{
+	TMInternedString *entry;
+
+	if (str == NULL)
+		return NULL;
+
+	g_mutex_lock(&interned_strings_mutex);
+	if (G_UNLIKELY(interned_strings == NULL))
+		interned_strings = g_hash_table_new(g_str_hash, g_str_equal);
+
+	entry = g_hash_table_lookup(interned_strings, str);
+	if (entry != NULL)
+		entry->refcount++;
+	else
+	{
+		gsize len = strlen(str);
+
+		entry = g_malloc(sizeof(TMInternedString) + len + 1);
+		entry->refcount = 1;
+		memcpy(entry->str, str, len + 1);
+		g_hash_table_insert(interned_strings, entry->str, entry);
+	}
+	g_mutex_unlock(&interned_strings_mutex);
+
+	return entry->str;
+}
+
+
+/*
+ Drops a reference to a string returned by tm_tag_intern_string().
+ @param str The interned string, can be NULL.
+*/
+void tm_tag_release_string(gchar *str)
+{
+	TMInternedString *entry;
+
+	if (str == NULL)
+		return;
+
+	entry = INTERNED_STRING(str);
+	g_mutex_lock(&interned_strings_mutex);
+	if (--entry->refcount == 0)
+	{
+		g_hash_table_remove(interned_strings, entry->str);
+		g_free(entry);
+	}
+	g_mutex_unlock(&interned_strings_mutex);
+}
+
+
 /*
  Destroys a TMTag structure, i.e. frees all elements except the tag itself.
  @param tag The TMTag structure to destroy
@@ -117,9 +241,9 @@ static void tm_tag_destroy(TMTag *tag)
 {
 	g_free(tag->name);
 	g_free(tag->arglist);
-	g_free(tag->scope);
-	g_free(tag->inheritance);
-	g_free(tag->var_type);
+	tm_tag_release_string(tag->scope);
+	tm_tag_release_string(tag->inheritance);
+	tm_tag_release_string(tag->var_type);
 }
 
 
@@ -134,8 +258,19 @@ void tm_tag_unref(TMTag *tag)
 	 * drop-in replacment of it */
 	if (NULL != tag && g_atomic_int_dec_and_test(&tag->refcount))
 	{
-		tm_tag_destroy(tag);
-		TAG_FREE(tag);
+		if (tag->arena)
+		{
+			/* only the interned strings belong to the tag itself */
+			tm_tag_release_string(tag->scope);
+			tm_tag_release_string(tag->inheritance);
+			tm_tag_release_string(tag->var_type);
+			tm_tag_arena_unref(tag->arena);
+		}
+		else
+		{
+			tm_tag_destroy(tag);
+			TAG_FREE(tag);
+		}
 	}
 }
 
@@ -194,7 +329,8 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				returnval = t1->type - t2->type;
 				break;
 			case tm_tag_attr_scope_t:
-				returnval = strcmp(FALLBACK(t1->scope, ""), FALLBACK(t2->scope, ""));
+				if (t1->scope != t2->scope)	/* interned, so equal pointers mean equal strings */
+					returnval = strcmp(FALLBACK(t1->scope, ""), FALLBACK(t2->scope, ""));
 				break;
 			case tm_tag_attr_arglist_t:
 				returnval = strcmp(FALLBACK(t1->arglist, ""), FALLBACK(t2->arglist, ""));
@@ -206,20 +342,21 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				}
 				break;
 			case tm_tag_attr_vartype_t:
-				returnval = strcmp(FALLBACK(t1->var_type, ""), FALLBACK(t2->var_type, ""));
+				if (t1->var_type != t2->var_type)
+					returnval = strcmp(FALLBACK(t1->var_type, ""), FALLBACK(t2->var_type, ""));
 				break;
 		}
 	}
 	return returnval;
 }
 
-gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
+/* Like tm_tags_equal() but ignores the line of the tags */
+gboolean tm_tags_equal_except_line(const TMTag *a, const TMTag *b)
 {
 	if (a == b)
 		return TRUE;
 
-	return (a->line == b->line &&
-			a->file == b->file /* ptr comparison */ &&
+	return (a->file == b->file /* ptr comparison */ &&
 			strcmp(FALLBACK(a->name, ""), FALLBACK(b->name, "")) == 0 &&
 			a->type == b->type &&
 			a->local == b->local &&
@@ -233,6 +370,11 @@ gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
 			strcmp(FALLBACK(a->var_type, ""), FALLBACK(b->var_type, "")) == 0);
 }
 
+gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
+{
+	return a->line == b->line && tm_tags_equal_except_line(a, b);
+}
+
 /*
  Removes NULL tag entries from an array of tags. Called after tm_tags_dedup() since 
  this function substitutes duplicate entries with NULL
@@ -303,6 +445,31 @@ void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 		tm_tags_dedup(tags_array, sort_attributes, unref_duplicates);
 }
 
+/*
+ Checks whether an array of tags is sorted on the specified attributes and
+ contains no duplicates, i.e. whether tm_tags_sort() with dedup would leave it
+ unchanged. This is cheaper than sorting already sorted arrays.
+ @param tags_array The array of tags to check
+ @param sort_attributes Attributes to be sorted on (int array terminated by 0)
+ @return TRUE if the array is sorted and duplicate-free
+*/
+gboolean tm_tags_is_sorted(GPtrArray *tags_array, TMTagAttrType *sort_attributes)
+{
+	TMSortOptions sort_options;
+	guint i;
+
+	g_return_val_if_fail(tags_array, FALSE);
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+	for (i = 1; i < tags_array->len; i++)
+	{
+		if (tm_tag_compare(&tags_array->pdata[i - 1], &tags_array->pdata[i], &sort_options) >= 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array)
 {
 	guint i;
@@ -598,15 +765,15 @@ static gint tag_search_cmp(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 TMTag **tm_tags_find(const GPtrArray *tags_array, const char *name,
 		gboolean partial, guint *tagCount)
 {
-	TMTag *tag, **first;
+	TMTag key = { 0 };
+	TMTag *tag = &key, **first;
 	TMSortOptions sort_options;
 
 	*tagCount = 0;
 	if (!tags_array || !tags_array->len)
 		return NULL;
 
-	tag = g_new0(TMTag, 1);
-	tag->name = (char *) name;
+	key.name = (char *) name;
 
 	sort_options.sort_attrs = NULL;
 	sort_options.partial = partial;
@@ -628,7 +795,6 @@ TMTag **tm_tags_find(const GPtrArray *tags_array, const char *name,
 		*tagCount = last - first + 1;
 	}
 
-	g_free(tag);
 	return (TMTag **) first;
 }
 
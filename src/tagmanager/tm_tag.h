@@ -95,12 +95,15 @@ typedef struct TMTag
 	gboolean local; /**< Is the tag of local scope */
 	guint pointerOrder;
 	char *arglist; /**< Argument list (functions/prototypes/macros) */
+	/* scope, inheritance and var_type are shared between tags and must not
+	 * be modified, see tm_tag_intern_string() */
 	char *scope; /**< Scope of tag */
 	char *inheritance; /**< Parent classes */
 	char *var_type; /**< Variable type (maps to struct for typedefs) */
 	char access; /**< Access type (public/protected/private/etc.) */
 	char impl; /**< Implementation (e.g. virtual) */
 	TMParserType lang; /* Programming language of the file */
+	struct TMTagArena *arena; /* block the tag was allocated in, see tm_tags_new_in_arena() */
 } TMTag;
 
 
@@ -111,8 +114,16 @@ typedef struct TMTag
 
 GType tm_tag_get_type(void) G_GNUC_CONST;
 
+typedef struct TMTagArena TMTagArena;
+
 TMTag *tm_tag_new(void);
 
+TMTag *tm_tags_new_in_arena(guint count, gpointer data, GDestroyNotify data_free);
+
+gchar *tm_tag_intern_string(const gchar *str);
+
+void tm_tag_release_string(gchar *str);
+
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array);
 
 GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array, 
@@ -121,6 +132,8 @@ GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array,
 void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates);
 
+gboolean tm_tags_is_sorted(GPtrArray *tags_array, TMTagAttrType *sort_attributes);
+
 GPtrArray *tm_tags_extract(GPtrArray *tags_array, guint tag_types);
 
 void tm_tags_prune(GPtrArray *tags_array);
@@ -140,6 +153,8 @@ TMTag *tm_tag_ref(TMTag *tag);
 
 gboolean tm_tags_equal(const TMTag *a, const TMTag *b);
 
+gboolean tm_tags_equal_except_line(const TMTag *a, const TMTag *b);
+
 const gchar *tm_tag_context_separator(TMParserType lang);
 
 gboolean tm_tag_is_anon(const TMTag *tag);
@@ -28,6 +28,9 @@
 #ifdef HAVE_GLOB_H
 # include <glob.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <glib/gstdio.h>
 
 #include "tm_workspace.h"
@@ -67,6 +70,42 @@ static TMTagType TM_GLOBAL_TYPE_MASK =
 
 static TMWorkspace *theWorkspace = NULL;
 
+/* Maps tag names to the position (+1) of the first tag with that name in
+ * theWorkspace->global_tags. Global tags change only when a tags file is
+ * loaded so the index is rebuilt then, see update_global_tags_index(). */
+static GHashTable *global_tags_index = NULL;
+
+/* Maps scopes to arrays of the global tags directly inside them, used for
+ * member completion. Built on first use, see get_global_scope_members(). */
+static GHashTable *global_scope_index = NULL;
+
+/* A tag and the initials of its name, see get_initials() */
+typedef struct
+{
+	const gchar *initials;
+	TMTag *tag;
+} InitialsEntry;
+
+/* The global tags sorted by case-insensitive name and by the initials of their
+ * names, for tm_workspace_find_completions(). Built on first use, see
+ * get_global_completion_index(). */
+typedef struct
+{
+	GPtrArray *by_name;
+	GArray *by_initials;	/* InitialsEntry */
+	GStringChunk *initials;
+} CompletionIndex;
+
+static CompletionIndex *global_completion_index = NULL;
+
+/* Number of threads reading and parsing source files in
+ * tm_workspace_add_source_files() */
+#define PARSE_THREADS_NUM 4
+
+/* Preprocessor output bigger than this is kept in a temporary file rather than
+ * in memory while generating global tags */
+#define PRE_PROCESS_MAX_MEMORY (10 * 1024 * 1024)
+
 
 static gboolean tm_create_workspace(void)
 {
@@ -85,6 +124,18 @@ static gboolean tm_create_workspace(void)
 }
 
 
+static void free_global_completion_index(void)
+{
+	if (!global_completion_index)
+		return;
+	g_ptr_array_free(global_completion_index->by_name, TRUE);
+	g_array_free(global_completion_index->by_initials, TRUE);
+	g_string_chunk_free(global_completion_index->initials);
+	g_free(global_completion_index);
+	global_completion_index = NULL;
+}
+
+
 /* Frees the workspace structure and all child source files. Use only when
  exiting from the main program.
 */
@@ -103,6 +154,13 @@ void tm_workspace_free(void)
 	g_ptr_array_free(theWorkspace->tags_array, TRUE);
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
+	if (global_tags_index)
+		g_hash_table_destroy(global_tags_index);
+	global_tags_index = NULL;
+	if (global_scope_index)
+		g_hash_table_destroy(global_scope_index);
+	global_scope_index = NULL;
+	free_global_completion_index();
 	g_free(theWorkspace);
 	theWorkspace = NULL;
 }
@@ -141,30 +199,109 @@ static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag
 }
 
 
-static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
+/* Compares the (sorted) tags of a file before and after a reparse */
+static TMTagsChange compare_file_tags(GPtrArray *old_tags, GPtrArray *new_tags)
+{
+	TMTagsChange change = TM_TAGS_UNCHANGED;
+	guint i;
+
+	if (old_tags->len != new_tags->len)
+		return TM_TAGS_CHANGED;
+
+	for (i = 0; i < old_tags->len; i++)
+	{
+		TMTag *old_tag = old_tags->pdata[i];
+		TMTag *new_tag = new_tags->pdata[i];
+
+		if (!tm_tags_equal_except_line(old_tag, new_tag))
+			return TM_TAGS_CHANGED;
+		if (old_tag->line != new_tag->line)
+			change = TM_TAGS_LINES_CHANGED;
+	}
+
+	return change;
+}
+
+
+/* Replaces the tags of old_tags in tags_array with the tags at the same
+ * position in new_tags. Only valid when the tags differ in their lines, which
+ * doesn't affect the sorting of tags_array. */
+static void replace_file_tags(GPtrArray *tags_array, GPtrArray *old_tags, GPtrArray *new_tags)
+{
+	guint i;
+
+	for (i = 0; i < old_tags->len; i++)
+	{
+		TMTag **found;
+		guint j, count;
+
+		found = tm_tags_find(tags_array, TM_TAG(old_tags->pdata[i])->name, FALSE, &count);
+		for (j = 0; j < count; j++)
+		{
+			if (found[j] == old_tags->pdata[i])
+			{
+				found[j] = new_tags->pdata[i];
+				break;
+			}
+		}
+	}
+}
+
+
+static TMTagsChange update_source_file(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size, gboolean use_buffer, gboolean update_workspace)
 {
+	GPtrArray *old_tags = NULL;
+	TMTagsChange change = TM_TAGS_CHANGED;
+
 #ifdef TM_DEBUG
 	g_message("Source file updating based on source file %s", source_file->file_name);
 #endif
 
 	if (update_workspace)
 	{
-		/* tm_source_file_parse() deletes the tag objects - remove the tags from
-		 * workspace while they exist and can be scanned */
-		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
-		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+		/* tm_source_file_parse() deletes the tag objects - keep them so they
+		 * can be compared with the new ones and removed from the workspace */
+		old_tags = source_file->tags_array;
+		source_file->tags_array = g_ptr_array_new();
 	}
 	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
 	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
 	if (update_workspace)
 	{
+		GPtrArray *new_tags = source_file->tags_array;
+
+		change = compare_file_tags(old_tags, new_tags);
+		if (change == TM_TAGS_UNCHANGED)
+		{
 #ifdef TM_DEBUG
-		g_message("Updating workspace from source file");
+			g_message("Tags unchanged, skipping workspace update");
 #endif
-		tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
+			/* the workspace still points to the old tags, just keep them */
+			source_file->tags_array = old_tags;
+			old_tags = new_tags;
+		}
+		else if (change == TM_TAGS_LINES_CHANGED)
+		{
+			replace_file_tags(theWorkspace->tags_array, old_tags, new_tags);
+			replace_file_tags(theWorkspace->typename_array, old_tags, new_tags);
+		}
+		else
+		{
+#ifdef TM_DEBUG
+			g_message("Updating workspace from source file");
+#endif
+			/* tm_tags_remove_file_tags() looks for the tags of source_file */
+			source_file->tags_array = old_tags;
+			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
+			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+			source_file->tags_array = new_tags;
+
+			tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
 
-		merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+			merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+		}
+		tm_tags_array_free(old_tags, TRUE);
 	}
 #ifdef TM_DEBUG
 	else
@@ -172,6 +309,8 @@ static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
 			update_workspace?"TRUE":"FALSE");
 
 #endif
+
+	return change;
 }
 
 
@@ -200,18 +339,21 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file)
  Ctags will use a parsing based on buffer instead of on files.
  You should call this function when you don't want a previous saving of the file
  you're editing. It's useful for a "real-time" updating of the tags.
- The tags array and the tags themselves are destroyed and re-created, hence any
- other tag arrays pointing to these tags should be rebuilt as well. All sorting
- information is also lost.
+ The new tags are compared with the previous ones: if they are identical the
+ previous tags are kept, if only their lines changed the workspace tag arrays
+ are patched in place. Otherwise the tags array and the tags themselves are
+ destroyed and re-created, hence any other tag arrays pointing to these tags
+ should be rebuilt as well.
  @param source_file The source file to update with a buffer.
  @param text_buf A text buffer. The user should take care of allocate and free it after
  the use here.
  @param buf_size The size of text_buf.
+ @return What changed in the tags of source_file.
 */
-void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
+TMTagsChange tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size)
 {
-	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE);
+	return update_source_file(source_file, text_buf, buf_size, TRUE, TRUE);
 }
 
 
@@ -240,6 +382,66 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 }
 
 
+/* Merges the (already sorted) tag arrays of all source files into a single
+ sorted array. The arrays are merged pairwise in rounds so every tag takes part
+ in log(number of files) merges only, which is cheaper than sorting all the
+ workspace tags again. */
+static GPtrArray *merge_source_files_tags(void)
+{
+	GPtrArray *arrays = g_ptr_array_new();
+	GPtrArray *res;
+	gboolean owned = FALSE;	/* whether the arrays are ours or the source files' */
+	guint i;
+
+	for (i = 0; i < theWorkspace->source_files->len; i++)
+	{
+		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
+
+		if (source_file->tags_array->len > 0)
+			g_ptr_array_add(arrays, source_file->tags_array);
+	}
+
+	while (arrays->len > 1)
+	{
+		GPtrArray *merged = g_ptr_array_sized_new(arrays->len / 2 + 1);
+
+		for (i = 0; i + 1 < arrays->len; i += 2)
+		{
+			GPtrArray *arr1 = arrays->pdata[i];
+			GPtrArray *arr2 = arrays->pdata[i + 1];
+
+			g_ptr_array_add(merged, tm_tags_merge(arr1, arr2, workspace_tags_sort_attrs, FALSE));
+			if (owned)
+			{
+				g_ptr_array_free(arr1, TRUE);
+				g_ptr_array_free(arr2, TRUE);
+			}
+		}
+		/* odd number of arrays - pass the last one to the next round */
+		if (i < arrays->len)
+		{
+			GPtrArray *arr = arrays->pdata[i];
+
+			g_ptr_array_add(merged, owned ? arr : tm_tags_extract(arr, tm_tag_max_t));
+		}
+
+		g_ptr_array_free(arrays, TRUE);
+		arrays = merged;
+		owned = TRUE;
+	}
+
+	if (arrays->len == 0)
+		res = g_ptr_array_new();
+	else if (owned)
+		res = arrays->pdata[0];
+	else
+		res = tm_tags_extract(arrays->pdata[0], tm_tag_max_t);
+	g_ptr_array_free(arrays, TRUE);
+
+	return res;
+}
+
+
 /* Recreates workspace tag array from all member TMSourceFile objects. Use if you 
  want to globally refresh the workspace. This function does not call tm_source_file_update()
  which should be called before this function on source files which need to be
@@ -247,43 +449,44 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 */
 static void tm_workspace_update(void)
 {
-	guint i, j;
-	TMSourceFile *source_file;
-
 #ifdef TM_DEBUG
 	g_message("Recreating workspace tags array");
+	g_message("Total %d objects", theWorkspace->source_files->len);
 #endif
 
-	g_ptr_array_set_size(theWorkspace->tags_array, 0);
+	g_ptr_array_free(theWorkspace->tags_array, TRUE);
+	theWorkspace->tags_array = merge_source_files_tags();
+	/* merging removes duplicates between files only, remove the ones inside files */
+	tm_tags_dedup(theWorkspace->tags_array, workspace_tags_sort_attrs, FALSE);
 
-#ifdef TM_DEBUG
-	g_message("Total %d objects", theWorkspace->source_files->len);
-#endif
-	for (i=0; i < theWorkspace->source_files->len; ++i)
-	{
-		source_file = theWorkspace->source_files->pdata[i];
-#ifdef TM_DEBUG
-		g_message("Adding tags of %s", source_file->file_name);
-#endif
-		if (source_file->tags_array->len > 0)
-		{
-			for (j = 0; j < source_file->tags_array->len; ++j)
-			{
-				g_ptr_array_add(theWorkspace->tags_array,
-					source_file->tags_array->pdata[j]);
-			}
-		}
-	}
 #ifdef TM_DEBUG
 	g_message("Total: %d tags", theWorkspace->tags_array->len);
 #endif
-	tm_tags_sort(theWorkspace->tags_array, workspace_tags_sort_attrs, TRUE, FALSE);
 
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
 }
 
 
+/* thread pool function reading and parsing a source file, only the source file
+ * itself is touched so the workspace is updated by the caller once all the
+ * files are parsed */
+static void parse_source_file(gpointer data, gpointer user_data)
+{
+	TMSourceFile *source_file = data;
+	gchar *contents;
+	gsize length;
+
+	/* without contents, the tags come from the cache or the file is parsed
+	 * directly (too big or couldn't be read - the latter just to report the
+	 * error the usual way) */
+	if (!tm_source_file_read_contents(source_file, &contents, &length))
+		contents = NULL;
+	update_source_file(source_file, (guchar *) contents, length, FALSE, FALSE);
+	g_free(contents);
+}
+
+
 /** Adds multiple source files to the workspace and updates the workspace tag arrays.
  This is more efficient than calling tm_workspace_add_source_file() and
  tm_workspace_update_source_file() separately for each of the files.
@@ -292,22 +495,45 @@ static void tm_workspace_update(void)
 GEANY_API_SYMBOL
 void tm_workspace_add_source_files(GPtrArray *source_files)
 {
+	GThreadPool *pool;
 	guint i;
 
 	g_return_if_fail(source_files != NULL);
 
+	/* the files are read and parsed in parallel, each thread holds at most one
+	 * file in memory */
+	pool = g_thread_pool_new(parse_source_file, NULL, PARSE_THREADS_NUM, FALSE, NULL);
+
 	for (i = 0; i < source_files->len; i++)
 	{
 		TMSourceFile *source_file = source_files->pdata[i];
-		
+
 		tm_workspace_add_source_file_noupdate(source_file);
-		update_source_file(source_file, NULL, 0, FALSE, FALSE);
+		g_thread_pool_push(pool, source_file, NULL);
 	}
-	
+
+	g_thread_pool_free(pool, FALSE, TRUE);
+
 	tm_workspace_update();
 }
 
 
+/* Removes tags belonging to any of the files in the removed set in a single pass */
+static void remove_files_tags(GHashTable *removed, GPtrArray *tags_array)
+{
+	guint i, j;
+
+	for (i = 0, j = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = tags_array->pdata[i];
+
+		if (!g_hash_table_contains(removed, tag->file))
+			tags_array->pdata[j++] = tag;
+	}
+	g_ptr_array_set_size(tags_array, j);
+}
+
+
 /** Removes multiple source files from the workspace and updates the workspace tag
  arrays. This is more efficient than calling tm_workspace_remove_source_file()
  separately for each of the files. To completely free the TMSourceFile pointers
@@ -317,26 +543,79 @@ void tm_workspace_add_source_files(GPtrArray *source_files)
 GEANY_API_SYMBOL
 void tm_workspace_remove_source_files(GPtrArray *source_files)
 {
+	GHashTable *removed;
 	guint i, j;
 
 	g_return_if_fail(source_files != NULL);
 
-	//TODO: sort both arrays by pointer value and remove in single pass
+	removed = g_hash_table_new(g_direct_hash, g_direct_equal);
 	for (i = 0; i < source_files->len; i++)
+		g_hash_table_add(removed, source_files->pdata[i]);
+
+	for (i = 0, j = 0; i < theWorkspace->source_files->len; i++)
 	{
-		TMSourceFile *source_file = source_files->pdata[i];
-		
-		for (j = 0; j < theWorkspace->source_files->len; j++)
+		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
+
+		if (!g_hash_table_contains(removed, source_file))
+			theWorkspace->source_files->pdata[j++] = source_file;
+	}
+	g_ptr_array_set_size(theWorkspace->source_files, j);
+
+	/* removing tags keeps the arrays sorted, no need to rebuild them */
+	remove_files_tags(removed, theWorkspace->tags_array);
+	remove_files_tags(removed, theWorkspace->typename_array);
+
+	g_hash_table_destroy(removed);
+}
+
+
+/* global_tags is sorted by name first so tags of the same name are adjacent and
+ * only the first one of each run has to be indexed. The keys are owned by the
+ * tags which stay alive as long as they are in global_tags. */
+static void update_global_tags_index(void)
+{
+	GPtrArray *tags = theWorkspace->global_tags;
+	const gchar *last_name = NULL;
+	guint i;
+
+	if (global_tags_index)
+		g_hash_table_remove_all(global_tags_index);
+	else
+		global_tags_index = g_hash_table_new(g_str_hash, g_str_equal);
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+
+		if (!last_name || strcmp(last_name, tag->name) != 0)
 		{
-			if (theWorkspace->source_files->pdata[j] == source_file)
-			{
-				g_ptr_array_remove_index_fast(theWorkspace->source_files, j);
-				break;
-			}
+			g_hash_table_insert(global_tags_index, tag->name, GUINT_TO_POINTER(i + 1));
+			last_name = tag->name;
 		}
 	}
-	
-	tm_workspace_update();
+}
+
+
+/* Like tm_tags_find() on global_tags for exact matches, but without the
+ * binary searches */
+static TMTag **find_global_tags(const char *name, guint *count)
+{
+	GPtrArray *tags = theWorkspace->global_tags;
+	guint first, last;
+
+	*count = 0;
+	first = GPOINTER_TO_UINT(g_hash_table_lookup(global_tags_index, name));
+	if (first == 0)
+		return NULL;
+
+	first--;
+	for (last = first + 1; last < tags->len; last++)
+	{
+		if (strcmp(TM_TAG(tags->pdata[last])->name, name) != 0)
+			break;
+	}
+	*count = last - first;
+	return (TMTag **) &tags->pdata[first];
 }
 
 
@@ -354,7 +633,9 @@ gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
 	if (!file_tags)
 		return FALSE;
 
-	tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+	/* files generated by tm_workspace_create_global_tags() are sorted already */
+	if (!tm_tags_is_sorted(file_tags, global_tags_sort_attrs))
+		tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
 
 	/* reorder the whole array, because tm_tags_find expects a sorted array */
 	new_tags = tm_tags_merge(theWorkspace->global_tags, 
@@ -362,6 +643,11 @@ gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
 	g_ptr_array_free(theWorkspace->global_tags, TRUE);
 	g_ptr_array_free(file_tags, TRUE);
 	theWorkspace->global_tags = new_tags;
+	update_global_tags_index();
+	if (global_scope_index)
+		g_hash_table_destroy(global_scope_index);
+	global_scope_index = NULL;
+	free_global_completion_index();
 
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
 	theWorkspace->global_typename_array = tm_tags_extract(new_tags, TM_GLOBAL_TYPE_MASK);
@@ -420,36 +706,73 @@ static gboolean write_includes_file(const gchar *outf, GList *includes_files)
 }
 
 
-static gboolean combine_include_files(const gchar *outf, GList *file_list)
+/* Output of the preprocessor or of the combined include files, to be parsed */
+typedef struct
 {
-	FILE *fp = g_fopen(outf, "w");
-	GList *node = file_list;
+	GString *buffer;	/* the contents when kept in memory */
+	gchar *file_name;	/* otherwise the temporary file holding them */
+	GMappedFile *map;	/* and its mapping */
+	gboolean complete;	/* FALSE if the preprocessor reported errors */
+} ShardContents;
 
-	if (!fp)
-		return FALSE;
+
+static const gchar *shard_contents_get_data(const ShardContents *contents)
+{
+	return contents->map ? g_mapped_file_get_contents(contents->map) : contents->buffer->str;
+}
+
+
+static gsize shard_contents_get_length(const ShardContents *contents)
+{
+	return contents->map ? g_mapped_file_get_length(contents->map) : contents->buffer->len;
+}
+
+
+static void shard_contents_clear(ShardContents *contents)
+{
+	if (contents->buffer)
+		g_string_free(contents->buffer, TRUE);
+	if (contents->map)
+		g_mapped_file_unref(contents->map);
+	if (contents->file_name)
+	{
+		g_unlink(contents->file_name);
+		g_free(contents->file_name);
+	}
+	memset(contents, 0, sizeof(*contents));
+}
+
+
+/* Reads the contents of all files in file_list, one after another */
+static void combine_include_files(GList *file_list, ShardContents *shard_contents)
+{
+	GString *contents = g_string_new(NULL);
+	GList *node = file_list;
 
 	while (node)
 	{
 		const char *fname = node->data;
-		char *contents;
+		char *file_contents;
 		size_t length;
 		GError *err = NULL;
 
-		if (! g_file_get_contents(fname, &contents, &length, &err))
+		if (! g_file_get_contents(fname, &file_contents, &length, &err))
 		{
 			fprintf(stderr, "Unable to read file: %s\n", err->message);
 			g_error_free(err);
 		}
 		else
 		{
-			fwrite(contents, length, 1, fp);
-			fwrite("\n", 1, 1, fp);	/* in case file doesn't end in newline (e.g. windows). */
-			g_free(contents);
+			g_string_append_len(contents, file_contents, length);
+			g_string_append_c(contents, '\n');	/* in case file doesn't end in newline (e.g. windows). */
+			g_free(file_contents);
 		}
 		node = g_list_next (node);
 	}
 
-	return fclose(fp) == 0;
+	memset(shard_contents, 0, sizeof(*shard_contents));
+	shard_contents->buffer = contents;
+	shard_contents->complete = TRUE;
 }
 
 
@@ -546,50 +869,234 @@ static GList *lookup_includes(const gchar **includes, gint includes_count)
 	return includes_files;
 }
 
-static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
+/* Runs the preprocessor on inf and reads its output from a pipe. Output
+ * bigger than PRE_PROCESS_MAX_MEMORY is moved to a temporary file which is
+ * parsed through a mapping, so that it doesn't take that much memory.
+ * Its error output goes to our stderr.
+ * @return FALSE if the preprocessor couldn't be run or was killed. */
+static gboolean pre_process_file(const gchar *cmd, const gchar *inf, ShardContents *contents)
 {
-	gint ret;
-	gchar *outf = create_temp_file("tmp_XXXXXX.cpp");
-	gchar *tmp_errfile;
-	gchar *errors = NULL;
 	gchar *command;
+	gchar buf[65536];
+	size_t len;
+	FILE *fp;
+	FILE *out = NULL;
+	gboolean ok = TRUE;
+	gint status;
 
-	if (!outf)
-		return NULL;
+	memset(contents, 0, sizeof(*contents));
 
-	tmp_errfile = create_temp_file("tmp_XXXXXX");
-	if (!tmp_errfile)
+	command = g_strdup_printf("%s %s", cmd, inf);
+#ifdef TM_DEBUG
+	g_message("Executing: %s", command);
+#endif
+	fp = popen(command, "r");
+	g_free(command);
+	if (!fp)
+		return FALSE;
+
+	contents->buffer = g_string_sized_new(sizeof(buf));
+	while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
 	{
-		g_unlink(outf);
-		g_free(outf);
-		return NULL;
+		if (!out && contents->buffer->len + len > PRE_PROCESS_MAX_MEMORY)
+		{
+			gint fd = g_file_open_tmp("tmp_XXXXXX.i", &contents->file_name, NULL);
+
+			out = fd < 0 ? NULL : fdopen(fd, "wb");
+			if (!out && fd >= 0)
+				close(fd);
+			ok = out && fwrite(contents->buffer->str, contents->buffer->len, 1, out) == 1;
+			g_string_free(contents->buffer, TRUE);
+			contents->buffer = NULL;
+			if (!ok)
+				break;
+		}
+		if (out)
+			ok = fwrite(buf, len, 1, out) == 1;
+		else
+			g_string_append_len(contents->buffer, buf, len);
+		if (!ok)
+			break;
+	}
+
+	status = pclose(fp);
+#ifdef HAVE_SYS_WAIT_H
+	if (status == -1 || !WIFEXITED(status))
+		ok = FALSE;
+	else
+		status = WEXITSTATUS(status);
+#else
+	if (status == -1)
+		ok = FALSE;
+#endif
+	/* the output is still used after errors like a missing header, the
+	 * preprocessor reported them */
+	contents->complete = (status == 0);
+	if (ok && status != 0)
+		g_warning("The preprocessor failed with exit status %d, the tags may be incomplete", status);
+
+	if (out)
+	{
+		ok = (fclose(out) == 0) && ok;
+		if (ok)
+			contents->map = g_mapped_file_new(contents->file_name, FALSE, NULL);
+		ok = ok && contents->map != NULL;
 	}
 
-	command = g_strdup_printf("%s %s >%s 2>%s",
-		cmd, inf, outf, tmp_errfile);
+	if (!ok)
+		shard_contents_clear(contents);
+	return ok;
+}
+
+typedef struct
+{
+	const gchar *pre_process;
+	GList *includes_files;
+	TMParserType lang;
+	gboolean use_cache;	/* includes_files is a single header to cache */
+	TMSourceFile *source_file;	/* the result, NULL on failure */
+} GlobalTagsShard;
+
+
+/* Returns the files the preprocessor read, taken from the line markers in its
+ * output such as: # 1 "/usr/include/stdio.h" 1 */
+static GPtrArray *get_pre_process_dependencies(const ShardContents *output, const gchar *includes_file)
+{
+	GPtrArray *dependencies = g_ptr_array_new_with_free_func(g_free);
+	GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+	const gchar *p = shard_contents_get_data(output);
+	const gchar *end = p + shard_contents_get_length(output);
+
+	while (p < end)
+	{
+		const gchar *eol = memchr(p, '\n', end - p);
+
+		if (!eol)
+			eol = end;
+		if (eol - p > 3 && p[0] == '#' && p[1] == ' ' && g_ascii_isdigit(p[2]))
+		{
+			const gchar *start = memchr(p, '"', eol - p);
+			const gchar *stop = start ? memchr(start + 1, '"', eol - start - 1) : NULL;
+
+			if (stop && start[1] != '<')
+			{
+				gchar *quoted = g_strndup(start + 1, stop - start - 1);
+				gchar *file_name = g_strcompress(quoted);
+
+				g_free(quoted);
+				if (strcmp(file_name, includes_file) != 0 &&
+					!g_hash_table_contains(seen, file_name))
+				{
+					g_ptr_array_add(dependencies, file_name);
+					g_hash_table_add(seen, file_name);
+				}
+				else
+					g_free(file_name);
+			}
+		}
+		p = eol + 1;
+	}
+	g_hash_table_destroy(seen);
+
+	return dependencies;
+}
+
+
+/* Identifies the tags of a header: besides the header itself, they depend on
+ * the preprocessor command and the directory it runs in */
+static gchar *get_header_cache_key(const GlobalTagsShard *shard)
+{
+	gchar *dir = g_get_current_dir();
+	gchar *key = g_strjoin("\n", "global tags", shard->pre_process ? shard->pre_process : "",
+		dir, (const gchar *) shard->includes_files->data, NULL);
+
+	g_free(dir);
+	return key;
+}
+
+
+/* Combines or preprocesses the include files of the shard and parses the
+ * result into shard->source_file, its tags sorted in global tags
+ * order. Uses the header cache if shard->use_cache is set. */
+static void create_global_tags_shard(gpointer data, gpointer user_data)
+{
+	GlobalTagsShard *shard = data;
+	/* the includes file for the preprocessor, also gives the source file
+	 * its name */
+	gchar *temp_file = create_temp_file("tmp_XXXXXX.cpp");
+	TMSourceFile *source_file = NULL;
+	ShardContents contents;
+	gchar *key = NULL;
+
+	if (!temp_file)
+		return;
+
+	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(shard->lang));
+	if (!source_file)
+		goto cleanup;
+
+	if (shard->use_cache)
+	{
+		GPtrArray *tags;
+
+		key = get_header_cache_key(shard);
+		tags = tm_source_file_read_header_cache(key, source_file);
+		if (tags)
+		{
 #ifdef TM_DEBUG
-	g_message("Executing: %s", command);
+			g_message("using cached tags of %s", (gchar *) shard->includes_files->data);
 #endif
-	ret = system(command);
-	g_free(command);
+			g_ptr_array_free(source_file->tags_array, TRUE);
+			source_file->tags_array = tags;
+			goto cleanup;
+		}
+	}
+
+	if (shard->pre_process)
+	{
+#ifdef TM_DEBUG
+		g_message ("writing out files to %s\n", temp_file);
+#endif
+		if (!write_includes_file(temp_file, shard->includes_files) ||
+			!pre_process_file(shard->pre_process, temp_file, &contents))
+			goto failure;
+	}
+	else
+		combine_include_files(shard->includes_files, &contents);
 
-	g_file_get_contents(tmp_errfile, &errors, NULL, NULL);
-	if (errors && *errors)
-		g_printerr("%s", errors);
-	g_free(errors);
-	g_unlink(tmp_errfile);
-	g_free(tmp_errfile);
+	tm_source_file_parse(source_file, (guchar *) shard_contents_get_data(&contents),
+		shard_contents_get_length(&contents), TRUE);
+	tm_tags_sort(source_file->tags_array, global_tags_sort_attrs, TRUE, FALSE);
 
-	if (ret == -1)
+	/* tags of a failed preprocessor run would be kept until a header changes */
+	if (shard->use_cache && contents.complete)
 	{
-		g_unlink(outf);
-		g_free(outf);
-		return NULL;
+		GPtrArray *dependencies;
+
+		if (shard->pre_process)
+			dependencies = get_pre_process_dependencies(&contents, temp_file);
+		else
+			dependencies = g_ptr_array_new_with_free_func(g_free);
+		if (dependencies->len == 0)
+			g_ptr_array_add(dependencies, g_strdup(shard->includes_files->data));
+		tm_source_file_write_header_cache(key, dependencies, source_file);
+		g_ptr_array_free(dependencies, TRUE);
 	}
+	shard_contents_clear(&contents);
+	goto cleanup;
 
-	return outf;
+failure:
+	tm_source_file_free(source_file);
+	source_file = NULL;
+
+cleanup:
+	shard->source_file = source_file;
+	g_unlink(temp_file);
+	g_free(temp_file);
+	g_free(key);
 }
 
+
 /* Creates a list of global tags. Ideally, this should be created once during
  installations so that all users can use the same file. This is because a full
  scale global tag list can occupy several megabytes of disk space.
@@ -599,65 +1106,90 @@ static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
  are allowed.
  @param tags_file The file where the tags will be stored.
  @param lang The language to use for the tags file.
+ @param binary Whether to write a binary tags file instead of a text one.
+ @param jobs The number of threads preprocessing and parsing the include files.
+ Without use_cache, the include files are split into as many groups. Tags found
+ in several groups are only written once.
+ @param use_cache Whether to process each include file on its own and keep its
+ tags in the tags cache, reusing them as long as none of the files it includes
+ changed.
  @return TRUE on success, FALSE on failure.
 */
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang)
+	int includes_count, const char *tags_file, TMParserType lang, gboolean binary, guint jobs,
+	gboolean use_cache)
 {
 	gboolean ret = FALSE;
-	TMSourceFile *source_file;
-	GList *includes_files;
-	gchar *temp_file = create_temp_file("tmp_XXXXXX.cpp");
-
-	if (!temp_file)
-		return FALSE;
+	GList *includes_files, *node;
+	GlobalTagsShard *shards;
+	GPtrArray *tags;
+	guint shard_count, i;
 
 	includes_files = lookup_includes(includes, includes_count);
+	jobs = MAX(jobs, 1);
+	if (use_cache)
+		shard_count = MAX(1, g_list_length(includes_files));
+	else
+		shard_count = MAX(1, MIN(jobs, g_list_length(includes_files)));
+	shards = g_new0(GlobalTagsShard, shard_count);
+	for (i = 0; i < shard_count; i++)
+	{
+		shards[i].pre_process = pre_process;
+		shards[i].lang = lang;
+		shards[i].use_cache = use_cache && includes_files != NULL;
+	}
+	for (node = includes_files, i = 0; node; node = node->next, i = (i + 1) % shard_count)
+		shards[i].includes_files = g_list_prepend(shards[i].includes_files, node->data);
 
-#ifdef TM_DEBUG
-	g_message ("writing out files to %s\n", temp_file);
-#endif
-	if (pre_process)
-		ret = write_includes_file(temp_file, includes_files);
+	if (jobs == 1 || shard_count == 1)
+	{
+		for (i = 0; i < shard_count; i++)
+			create_global_tags_shard(&shards[i], NULL);
+	}
 	else
-		ret = combine_include_files(temp_file, includes_files);
+	{
+		/* each shard preprocesses and parses its headers in its own thread */
+		GThreadPool *pool = g_thread_pool_new(create_global_tags_shard, NULL,
+			jobs, TRUE, NULL);
 
-	g_list_free_full(includes_files, g_free);
-	if (!ret)
-		goto cleanup;
-	ret = FALSE;
+		for (i = 0; i < shard_count; i++)
+			g_thread_pool_push(pool, &shards[i], NULL);
+		g_thread_pool_free(pool, FALSE, TRUE);
+	}
 
-	if (pre_process)
+	/* headers included by several shards give the same tags several times,
+	 * tm_tags_merge() drops the duplicates */
+	tags = g_ptr_array_new();
+	for (i = 0; i < shard_count; i++)
 	{
-		gchar *temp_file2 = pre_process_file(pre_process, temp_file);
+		GPtrArray *merged;
 
-		if (temp_file2)
-		{
-			g_unlink(temp_file);
-			g_free(temp_file);
-			temp_file = temp_file2;
-		}
-		else
+		if (!shards[i].source_file)
 			goto cleanup;
-	}
 
-	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(lang));
-	if (!source_file)
-		goto cleanup;
-	update_source_file(source_file, NULL, 0, FALSE, FALSE);
-	if (source_file->tags_array->len == 0)
-	{
-		tm_source_file_free(source_file);
-		goto cleanup;
+		merged = tm_tags_merge(tags, shards[i].source_file->tags_array,
+			global_tags_sort_attrs, FALSE);
+		g_ptr_array_free(tags, TRUE);
+		tags = merged;
 	}
+	if (tags->len == 0)
+		goto cleanup;
 
-	tm_tags_sort(source_file->tags_array, global_tags_sort_attrs, TRUE, FALSE);
-	ret = tm_source_file_write_tags_file(tags_file, source_file->tags_array);
-	tm_source_file_free(source_file);
+	if (binary)
+		ret = tm_source_file_write_binary_tags_file(tags_file, tags);
+	else
+		ret = tm_source_file_write_tags_file(tags_file, tags);
 
 cleanup:
-	g_unlink(temp_file);
-	g_free(temp_file);
+	g_ptr_array_free(tags, TRUE);
+	for (i = 0; i < shard_count; i++)
+	{
+		if (shards[i].source_file)
+			tm_source_file_free(shards[i].source_file);
+		g_list_free(shards[i].includes_files);
+	}
+	g_free(shards);
+	g_list_free_full(includes_files, g_free);
 	return ret;
 }
 
@@ -671,7 +1203,10 @@ static void fill_find_tags_array(GPtrArray *dst, const GPtrArray *src,
 	if (!src || !dst || !name || !*name)
 		return;
 
-	tag = tm_tags_find(src, name, FALSE, &num);
+	if (src == theWorkspace->global_tags && global_tags_index)
+		tag = find_global_tags(name, &num);
+	else
+		tag = tm_tags_find(src, name, FALSE, &num);
 	for (i = 0; i < num; ++i)
 	{
 		if ((type & (*tag)->type) &&
@@ -737,6 +1272,8 @@ static void fill_find_tags_array_prefix(GPtrArray *dst, const GPtrArray *src,
 
 /* Returns tags with the specified prefix sorted by name. If there are several
  tags with the same name, only one of them appears in the resulting array.
+ When there are more than max_num matches, tags from the workspace are preferred
+ over global tags.
  @param prefix The prefix of the tag to find.
  @param lang Specifies the language(see the table in parsers.h) of the tags to be found,
              -1 for all.
@@ -745,20 +1282,395 @@ static void fill_find_tags_array_prefix(GPtrArray *dst, const GPtrArray *src,
 */
 GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint max_num)
 {
-	TMTagAttrType attrs[] = { tm_tag_attr_name_t, 0 };
-	GPtrArray *tags = g_ptr_array_new();
+	GPtrArray *workspace_tags = g_ptr_array_new();
+	GPtrArray *global_tags = g_ptr_array_new();
+	GPtrArray *tags;
+	guint i = 0, j = 0, global_num;
+
+	/* both results are sorted by name and contain each name only once, so
+	 * they can be merged instead of sorted */
+	fill_find_tags_array_prefix(workspace_tags, theWorkspace->tags_array, prefix, lang, max_num);
+	fill_find_tags_array_prefix(global_tags, theWorkspace->global_tags, prefix, lang, max_num);
+
+	tags = g_ptr_array_sized_new(MIN(max_num, workspace_tags->len + global_tags->len));
+	global_num = max_num - workspace_tags->len;
+	while (i < workspace_tags->len || j < global_tags->len)
+	{
+		gint cmp;
 
-	fill_find_tags_array_prefix(tags, theWorkspace->tags_array, prefix, lang, max_num);
-	fill_find_tags_array_prefix(tags, theWorkspace->global_tags, prefix, lang, max_num);
+		if (i == workspace_tags->len)
+			cmp = -1;
+		else if (j == global_tags->len)
+			cmp = 1;
+		else
+			cmp = strcmp(TM_TAG(global_tags->pdata[j])->name, TM_TAG(workspace_tags->pdata[i])->name);
+
+		if (cmp < 0)
+		{
+			if (global_num == 0)
+			{
+				/* no room left for global tags, only workspace tags remain */
+				j = global_tags->len;
+				continue;
+			}
+			g_ptr_array_add(tags, global_tags->pdata[j++]);
+			global_num--;
+		}
+		else
+		{
+			/* a global tag of the same name is hidden by the workspace one */
+			if (cmp == 0)
+				j++;
+			g_ptr_array_add(tags, workspace_tags->pdata[i++]);
+		}
+	}
 
-	tm_tags_sort(tags, attrs, TRUE, FALSE);
-	if (tags->len > max_num)
-		tags->len = max_num;
+	g_ptr_array_free(workspace_tags, TRUE);
+	g_ptr_array_free(global_tags, TRUE);
 
 	return tags;
 }
 
 
+/* Writes the lowercase initials of the words of name to buf, that is its first
+ letter or digit and every one following a separator or starting a CamelCase word,
+ e.g. "gfb" for both getFooBar and g_foo_bar. */
+static void get_initials(const gchar *name, gchar *buf, gsize size)
+{
+	gchar prev = '_';
+	gsize len = 0;
+
+	for (; *name && len + 1 < size; name++)
+	{
+		if (g_ascii_isalnum(*name) &&
+			(!g_ascii_isalnum(prev) || (g_ascii_isupper(*name) && !g_ascii_isupper(prev))))
+			buf[len++] = g_ascii_tolower(*name);
+		prev = *name;
+	}
+	buf[len] = '\0';
+}
+
+
+/* Orders names case-insensitively, and names differing only in case by strcmp() */
+static gint compare_names_nocase(const gchar *a, const gchar *b)
+{
+	gint cmp = g_ascii_strcasecmp(a, b);
+
+	return cmp != 0 ? cmp : strcmp(a, b);
+}
+
+
+static gint compare_tags_by_name_nocase(gconstpointer a, gconstpointer b)
+{
+	return compare_names_nocase(TM_TAG(*((TMTag **) a))->name, TM_TAG(*((TMTag **) b))->name);
+}
+
+
+/* Orders by initials when both entries have them, then by name and puts workspace
+ tags before global ones of the same name */
+static gint compare_initials_entries(gconstpointer a, gconstpointer b)
+{
+	const InitialsEntry *entry_a = a;
+	const InitialsEntry *entry_b = b;
+	gint cmp = 0;
+
+	if (entry_a->initials && entry_b->initials)
+		cmp = strcmp(entry_a->initials, entry_b->initials);
+	if (cmp == 0)
+		cmp = compare_names_nocase(entry_a->tag->name, entry_b->tag->name);
+	if (cmp == 0)
+		cmp = (entry_a->tag->file == NULL) - (entry_b->tag->file == NULL);
+	return cmp;
+}
+
+
+static CompletionIndex *get_global_completion_index(void)
+{
+	GPtrArray *tags = theWorkspace->global_tags;
+	gchar initials[64];
+	guint i;
+
+	if (global_completion_index)
+		return global_completion_index;
+
+	global_completion_index = g_new(CompletionIndex, 1);
+	global_completion_index->by_name = g_ptr_array_sized_new(tags->len);
+	global_completion_index->by_initials = g_array_sized_new(FALSE, FALSE,
+		sizeof(InitialsEntry), tags->len);
+	global_completion_index->initials = g_string_chunk_new(4096);
+
+	for (i = 0; i < tags->len; i++)
+	{
+		InitialsEntry entry;
+
+		entry.tag = tags->pdata[i];
+		if (tm_tag_is_anon(entry.tag))
+			continue;
+		get_initials(entry.tag->name, initials, sizeof(initials));
+		/* most initials are short and shared by many names */
+		entry.initials = g_string_chunk_insert_const(global_completion_index->initials, initials);
+		g_ptr_array_add(global_completion_index->by_name, entry.tag);
+		g_array_append_val(global_completion_index->by_initials, entry);
+	}
+	g_ptr_array_sort(global_completion_index->by_name, compare_tags_by_name_nocase);
+	g_array_sort(global_completion_index->by_initials, compare_initials_entries);
+
+	return global_completion_index;
+}
+
+
+/* Gets the tags of the name-sorted tags_array whose names start with c */
+static TMTag **find_tags_by_first_char(const GPtrArray *tags_array, gchar c, guint *count)
+{
+	guint first = 0, last = tags_array->len, end;
+
+	while (first < last)
+	{
+		guint mid = (first + last) / 2;
+
+		if ((guchar) TM_TAG(tags_array->pdata[mid])->name[0] < (guchar) c)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	for (end = first; end < tags_array->len; end++)
+	{
+		if (TM_TAG(tags_array->pdata[end])->name[0] != c)
+			break;
+	}
+	*count = end - first;
+	return (TMTag **) &tags_array->pdata[first];
+}
+
+
+/* Whether tag can be offered for completion and its name isn't offered yet */
+static gboolean is_completion_candidate(const TMTag *tag, TMParserType lang, GHashTable *names)
+{
+	return tm_tag_langs_compatible(lang, tag->lang) && !tm_tag_is_anon(tag) &&
+		!g_hash_table_contains(names, tag->name);
+}
+
+
+/* Adds the tags of candidates to tags in order, each name once, until there are max_num */
+static void add_completion_candidates(GPtrArray *tags, GArray *candidates, GHashTable *names,
+	guint max_num)
+{
+	guint i;
+
+	g_array_sort(candidates, compare_initials_entries);
+	for (i = 0; i < candidates->len && tags->len < max_num; i++)
+	{
+		TMTag *tag = g_array_index(candidates, InitialsEntry, i).tag;
+
+		if (!g_hash_table_contains(names, tag->name))
+		{
+			g_ptr_array_add(tags, tag);
+			g_hash_table_add(names, tag->name);
+		}
+	}
+}
+
+
+/* Adds the tags whose names start with root in another case. Workspace tags are
+ scanned, global tags are looked up in the index and only the first max_num names
+ can make it into the result. */
+static void add_nocase_completions(GPtrArray *tags, const char *root, TMParserType lang,
+	GHashTable *names, guint max_num)
+{
+	GPtrArray *by_name = get_global_completion_index()->by_name;
+	GArray *candidates = g_array_new(FALSE, FALSE, sizeof(InitialsEntry));
+	gchar first_chars[] = { g_ascii_toupper(root[0]), g_ascii_tolower(root[0]) };
+	gsize root_len = strlen(root);
+	const gchar *last = NULL;
+	guint first, last_pos, i, j, count, num = 0;
+	InitialsEntry entry = { NULL, NULL };
+
+	/* the workspace tags are sorted by name, so only the ones starting with
+	 * either case of the first character need to be checked */
+	for (j = 0; j < G_N_ELEMENTS(first_chars); j++)
+	{
+		TMTag **tag;
+
+		if (j > 0 && first_chars[j] == first_chars[0])
+			break;
+		tag = find_tags_by_first_char(theWorkspace->tags_array, first_chars[j], &count);
+		for (i = 0; i < count; i++, tag++)
+		{
+			entry.tag = *tag;
+			if (g_ascii_strncasecmp(entry.tag->name, root, root_len) == 0 &&
+				is_completion_candidate(entry.tag, lang, names))
+				g_array_append_val(candidates, entry);
+		}
+	}
+
+	/* the first name not before root, ignoring case */
+	first = 0;
+	last_pos = by_name->len;
+	while (first < last_pos)
+	{
+		guint mid = (first + last_pos) / 2;
+
+		if (g_ascii_strncasecmp(TM_TAG(by_name->pdata[mid])->name, root, root_len) < 0)
+			first = mid + 1;
+		else
+			last_pos = mid;
+	}
+	for (i = first; i < by_name->len && num < max_num; i++)
+	{
+		entry.tag = by_name->pdata[i];
+		if (g_ascii_strncasecmp(entry.tag->name, root, root_len) != 0)
+			break;
+		if (is_completion_candidate(entry.tag, lang, names))
+		{
+			g_array_append_val(candidates, entry);
+			if (!last || strcmp(last, entry.tag->name) != 0)
+				num++;
+			last = entry.tag->name;
+		}
+	}
+
+	add_completion_candidates(tags, candidates, names, max_num);
+	g_array_free(candidates, TRUE);
+}
+
+
+/* Adds the tags whose initials start with root, see get_initials() */
+static void add_initials_completions(GPtrArray *tags, const char *root, TMParserType lang,
+	GHashTable *names, guint max_num)
+{
+	GArray *by_initials = get_global_completion_index()->by_initials;
+	GArray *candidates = g_array_new(FALSE, FALSE, sizeof(InitialsEntry));
+	GStringChunk *workspace_initials = g_string_chunk_new(256);
+	gchar *lower_root = g_ascii_strdown(root, -1);
+	/* the initials start with the first letter or digit, which may follow underscores */
+	gchar first_chars[] = { g_ascii_toupper(root[0]), g_ascii_tolower(root[0]), '_' };
+	gsize root_len = strlen(root);
+	const gchar *last = NULL;
+	gchar initials[64];
+	guint first, last_pos, i, j, count, num = 0;
+
+	for (j = 0; j < G_N_ELEMENTS(first_chars); j++)
+	{
+		TMTag **tag;
+
+		if (j > 0 && first_chars[j] == first_chars[j - 1])
+			continue;
+		tag = find_tags_by_first_char(theWorkspace->tags_array, first_chars[j], &count);
+		for (i = 0; i < count; i++, tag++)
+		{
+			InitialsEntry entry;
+
+			entry.tag = *tag;
+			get_initials(entry.tag->name, initials, sizeof(initials));
+			if (strncmp(initials, lower_root, root_len) == 0 &&
+				is_completion_candidate(entry.tag, lang, names))
+			{
+				entry.initials = g_string_chunk_insert_const(workspace_initials, initials);
+				g_array_append_val(candidates, entry);
+			}
+		}
+	}
+
+	first = 0;
+	last_pos = by_initials->len;
+	while (first < last_pos)
+	{
+		guint mid = (first + last_pos) / 2;
+
+		if (strncmp(g_array_index(by_initials, InitialsEntry, mid).initials, lower_root, root_len) < 0)
+			first = mid + 1;
+		else
+			last_pos = mid;
+	}
+	for (i = first; i < by_initials->len && num < max_num; i++)
+	{
+		InitialsEntry *entry = &g_array_index(by_initials, InitialsEntry, i);
+
+		if (strncmp(entry->initials, lower_root, root_len) != 0)
+			break;
+		if (is_completion_candidate(entry->tag, lang, names))
+		{
+			g_array_append_val(candidates, *entry);
+			if (!last || strcmp(last, entry->tag->name) != 0)
+				num++;
+			last = entry->tag->name;
+		}
+	}
+
+	add_completion_candidates(tags, candidates, names, max_num);
+	g_array_free(candidates, TRUE);
+	g_string_chunk_free(workspace_initials);
+	g_free(lower_root);
+}
+
+
+/* Returns the tags to offer when completing root, ranked by how well they match.
+ First come the tags tm_workspace_find_prefix() returns, then the ones whose names
+ start with root in another case, sorted case-insensitively, and then the ones whose
+ initials start with root, e.g. getFooBar for "gfb", sorted by their initials. Each
+ name appears only once, workspace tags are preferred over global tags.
+ @param root The text to complete.
+ @param lang Specifies the language(see the table in parsers.h) of the tags to be found,
+             -1 for all.
+ @param max_num The maximum number of tags to return.
+ @return Array of matching tags, best matches first.
+*/
+GPtrArray *tm_workspace_find_completions(const char *root, TMParserType lang, guint max_num)
+{
+	GPtrArray *tags = tm_workspace_find_prefix(root, lang, max_num);
+	GHashTable *names;
+	guint i;
+
+	if (tags->len >= max_num || !root || !*root)
+		return tags;
+
+	names = g_hash_table_new(g_str_hash, g_str_equal);
+	for (i = 0; i < tags->len; i++)
+		g_hash_table_add(names, TM_TAG(tags->pdata[i])->name);
+
+	add_nocase_completions(tags, root, lang, names, max_num);
+	if (tags->len < max_num)
+		add_initials_completions(tags, root, lang, names, max_num);
+
+	g_hash_table_destroy(names);
+	return tags;
+}
+
+
+/* Returns the global tags whose scope is exactly scope, or NULL */
+static const GPtrArray *get_global_scope_members(const gchar *scope)
+{
+	if (!global_scope_index)
+	{
+		GPtrArray *tags = theWorkspace->global_tags;
+		guint i;
+
+		global_scope_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+			NULL, (GDestroyNotify) g_ptr_array_unref);
+
+		for (i = 0; i < tags->len; i++)
+		{
+			TMTag *tag = tags->pdata[i];
+			GPtrArray *members;
+
+			if (!tag->scope || tag->scope[0] == '\0')
+				continue;
+
+			/* the key is owned by the tag, kept alive by global_tags */
+			members = g_hash_table_lookup(global_scope_index, tag->scope);
+			if (!members)
+			{
+				members = g_ptr_array_new();
+				g_hash_table_insert(global_scope_index, tag->scope, members);
+			}
+			g_ptr_array_add(members, tag);
+		}
+	}
+
+	return g_hash_table_lookup(global_scope_index, scope);
+}
+
+
 /* Gets all members of type_tag; search them inside the all array.
  * The namespace parameter determines whether we are performing the "namespace"
  * search (user has typed something like "A::" where A is a type) or "scope" search
@@ -782,7 +1694,11 @@ find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespa
 	else
 		scope = g_strdup(type_tag->name);
 
-	for (i = 0; i < all->len; ++i)
+	/* global tags can be huge, avoid scanning them */
+	if (all == theWorkspace->global_tags)
+		all = get_global_scope_members(scope);
+
+	for (i = 0; all && i < all->len; ++i)
 	{
 		TMTag *tag = TM_TAG (all->pdata[i]);
 
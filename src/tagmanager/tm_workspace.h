@@ -45,25 +45,36 @@ void tm_workspace_remove_source_files(GPtrArray *source_files);
 
 #ifdef GEANY_PRIVATE
 
+/* What changed after reparsing a file, see tm_workspace_update_source_file_buffer() */
+typedef enum
+{
+	TM_TAGS_UNCHANGED,	/* the tags are identical */
+	TM_TAGS_LINES_CHANGED,	/* only the line numbers of some tags changed */
+	TM_TAGS_CHANGED	/* tags were added, removed or modified */
+} TMTagsChange;
+
 const TMWorkspace *tm_get_workspace(void);
 
 gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode);
 
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang);
+	int includes_count, const char *tags_file, TMParserType lang, gboolean binary, guint jobs,
+	gboolean use_cache);
 
 GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type,
 	TMTagAttrType *attrs, TMParserType lang);
 
 GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint max_num);
 
+GPtrArray *tm_workspace_find_completions(const char *root, TMParserType lang, guint max_num);
+
 GPtrArray *tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 	gboolean function, gboolean member, const gchar *current_scope, gboolean search_namespace);
 
 
 void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file);
 
-void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
+TMTagsChange tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size);
 
 void tm_workspace_free(void);
@@ -295,6 +295,11 @@ static gchar *create_statusbar_statistics(GeanyDocument *doc,
 				break;
 			case 'f':
 				g_string_append(stats_str, filetypes_get_display_name(doc->file_type));
+				if (doc->priv->large_file)
+				{
+					g_string_append_c(stats_str, ' ');
+					g_string_append(stats_str, _("(large file)"));
+				}
 				break;
 			case 'S':
 				symbols_get_current_scope(doc, &cur_tag);
@@ -1081,6 +1086,10 @@ void ui_document_show_hide(GeanyDocument *doc)
 	gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item), doc->has_bom);
 	ui_widget_set_sensitive(item, encodings_is_unicode_charset(doc->encoding));
 
+	item = ui_lookup_widget(main_widgets.window, "menu_large_file_mode1");
+	gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item), doc->priv->large_file);
+	ui_widget_set_sensitive(item, doc->priv->large_file);
+
 	switch (sci_get_eol_mode(doc->editor->sci))
 	{
 		case SC_EOL_CR: widget_name = "cr"; break;
@@ -102,8 +102,7 @@ void utils_open_browser(const gchar *uri)
 gint utils_get_line_endings(const gchar* buffer, gsize size)
 {
 	gsize i;
-	guint cr, lf, crlf, max_mode;
-	gint mode;
+	guint cr, lf, crlf;
 
 	cr = lf = crlf = 0;
 
@@ -138,7 +137,16 @@ gint utils_get_line_endings(const gchar* buffer, gsize size)
 		}
 	}
 
-	/* Vote for the maximum */
+	return utils_get_line_endings_from_counts(cr, lf, crlf);
+}
+
+
+/* Votes for the line endings used most, given how many of each there are */
+gint utils_get_line_endings_from_counts(gsize cr, gsize lf, gsize crlf)
+{
+	gsize max_mode;
+	gint mode;
+
 	mode = SC_EOL_LF;
 	max_mode = lf;
 	if (crlf > max_mode)
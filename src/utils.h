@@ -228,6 +228,8 @@ typedef enum
 
 gint utils_get_line_endings(const gchar* buffer, gsize size);
 
+gint utils_get_line_endings_from_counts(gsize cr, gsize lf, gsize crlf);
+
 gboolean utils_isbrace(gchar c, gboolean include_angles);
 
 gboolean utils_is_opening_brace(gchar c, gboolean include_angles);
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# Fails if a parser allocates more than recorded in parsers.baseline. Unlike
+# timings, allocation counts don't depend on the machine, so this is part of
+# "make check".
+
+exec ./tm_bench -p -a -b "${srcdir:-.}/parsers.baseline" "${srcdir:-.}/../ctags"
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# Fails if a parser got slower than recorded in parsers.baseline, allowing for
+# BENCH_TOLERANCE percent (default: 50) of noise, or allocates more.
+
+exec ./tm_bench -p -n 5 -t "${BENCH_TOLERANCE:-50}" \
+	-b "${srcdir:-.}/parsers.baseline" "${srcdir:-.}/../ctags"
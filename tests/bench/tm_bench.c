@@ -0,0 +1,825 @@
+/*
+ *      tm_bench.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Headless benchmark of the tag manager: times parsing, sorting and merging of
+ * tags and the workspace lookups used by calltips and autocompletion over a
+ * set of source files. Run with "make bench".
+ *
+ * With -p, only the throughput and the allocations of each parser are measured,
+ * and optionally compared against a baseline file; this is what
+ * "make bench-check" runs. Adding -a skips the timings and only compares the
+ * allocation counts, which don't depend on the machine; this is what
+ * "make check" runs.
+ */
+
+#include "tm_ctags_wrappers.h"
+#include "tm_source_file.h"
+#include "tm_tag.h"
+#include "tm_workspace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#ifdef G_OS_UNIX
+# include <sys/resource.h>
+#endif
+
+
+/* same as in tm_workspace.c */
+static TMTagAttrType workspace_tags_sort_attrs[] =
+{
+	tm_tag_attr_name_t, tm_tag_attr_file_t, tm_tag_attr_line_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+static TMTagAttrType file_tags_sort_attrs[] =
+{
+	tm_tag_attr_name_t, tm_tag_attr_line_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+#define TYPES_WITH_MEMBERS (tm_tag_class_t | tm_tag_struct_t | tm_tag_union_t | \
+	tm_tag_enum_t | tm_tag_interface_t)
+
+/* default number of entries in the autocompletion list */
+#define PREFIX_MAX_NUM 30
+/* default number of characters typed before autocompletion starts */
+#define PREFIX_LEN 4
+
+typedef struct
+{
+	gchar *file_name;
+	TMParserType lang;
+	gchar *contents;
+	gsize length;
+} BenchFile;
+
+/* shorter timings are too noisy to compare against the baseline, so the input
+ * is parsed as many times as needed to take at least this long */
+#define MIN_TIMED_USECS 20000
+
+typedef struct
+{
+	TMParserType lang;
+	gsize bytes;
+	guint tags;
+	gulong allocations;	/* ctags allocations of one parse of the input */
+	gdouble usecs;	/* of one parse of the input, best of all iterations */
+} ParserResult;
+
+typedef struct
+{
+	gdouble cost;	/* 0 if unknown */
+	gulong allocations;
+} BaselineEntry;
+
+static gint iterations = 3;
+static gchar *global_tags_file = NULL;
+static gchar *global_tags_lang = NULL;
+static gboolean parsers_only = FALSE;
+static gint scale = 1;
+static gchar *baseline_file = NULL;
+static gchar *new_baseline_file = NULL;
+static gint tolerance = 50;
+static gboolean allocations_only = FALSE;
+static gint alloc_tolerance = 5;
+
+static GOptionEntry entries[] =
+{
+	{ "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations, "Number of times each step is repeated (default: 3)", "N" },
+	{ "global-tags", 'g', 0, G_OPTION_ARG_FILENAME, &global_tags_file, "Load a global tags file before the lookups", "FILE" },
+	{ "global-lang", 'l', 0, G_OPTION_ARG_STRING, &global_tags_lang, "Language of the global tags file (default: C)", "NAME" },
+	{ "parsers", 'p', 0, G_OPTION_ARG_NONE, &parsers_only, "Only measure the throughput and allocations of each parser", NULL },
+	{ "allocations", 'a', 0, G_OPTION_ARG_NONE, &allocations_only, "With -p, only count the allocations of each parser", NULL },
+	{ "scale", 's', 0, G_OPTION_ARG_INT, &scale, "Repeat the contents of each file N times (default: 1)", "N" },
+	{ "baseline", 'b', 0, G_OPTION_ARG_FILENAME, &baseline_file, "Compare parser throughput and allocations against FILE", "FILE" },
+	{ "write-baseline", 'w', 0, G_OPTION_ARG_FILENAME, &new_baseline_file, "Write parser throughput and allocations to FILE", "FILE" },
+	{ "tolerance", 't', 0, G_OPTION_ARG_INT, &tolerance, "Allowed slowdown against the baseline, in percent (default: 50)", "PERCENT" },
+	{ "alloc-tolerance", 'A', 0, G_OPTION_ARG_INT, &alloc_tolerance, "Allowed allocation increase against the baseline, in percent (default: 5)", "PERCENT" },
+	{ NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+
+static gint compare_strings(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*((const gchar **) a), *((const gchar **) b));
+}
+
+
+/* Adds the files in path (recursively if it is a directory) to files,
+ * skipping those ctags doesn't know */
+static void collect_files(const gchar *path, GPtrArray *files)
+{
+	if (g_file_test(path, G_FILE_TEST_IS_DIR))
+	{
+		GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+		GDir *dir = g_dir_open(path, 0, NULL);
+		const gchar *name;
+		guint i;
+
+		if (!dir)
+			return;
+		while ((name = g_dir_read_name(dir)) != NULL)
+			g_ptr_array_add(names, g_build_filename(path, name, NULL));
+		g_dir_close(dir);
+
+		/* sort for reproducible results */
+		g_ptr_array_sort(names, compare_strings);
+		for (i = 0; i < names->len; i++)
+			collect_files(names->pdata[i], files);
+		g_ptr_array_free(names, TRUE);
+	}
+	else
+	{
+		TMParserType lang = tm_ctags_get_file_lang(path);
+		BenchFile *file;
+		gchar *contents;
+		gsize length;
+
+		if (lang == TM_PARSER_NONE || !g_file_get_contents(path, &contents, &length, NULL))
+			return;
+
+		if (scale > 1)
+		{
+			GString *scaled = g_string_sized_new(length * scale);
+			gint i;
+
+			for (i = 0; i < scale; i++)
+				g_string_append_len(scaled, contents, length);
+			g_free(contents);
+			length = scaled->len;
+			contents = g_string_free(scaled, FALSE);
+		}
+
+		file = g_new0(BenchFile, 1);
+		file->file_name = tm_get_real_path(path);
+		file->lang = lang;
+		file->contents = contents;
+		file->length = length;
+		g_ptr_array_add(files, file);
+	}
+}
+
+
+static void print_result(const gchar *step, gint64 usecs, gdouble amount, const gchar *unit)
+{
+	gdouble secs = usecs / (gdouble) G_USEC_PER_SEC;
+
+	printf("%-24s %10.3f s %14.1f %s/s\n", step, secs,
+		secs > 0 ? amount / secs : 0.0, unit);
+}
+
+
+static void print_peak_memory(void)
+{
+#ifdef G_OS_UNIX
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		/* bytes instead of kilobytes */
+		usage.ru_maxrss /= 1024;
+#endif
+		printf("%-24s %10ld KiB\n", "peak memory", (glong) usage.ru_maxrss);
+	}
+#endif
+}
+
+
+/* Parses all files from memory, like when editing. The source files aren't part
+ * of the workspace. */
+static GPtrArray *bench_parse(GPtrArray *files, guint *tag_count)
+{
+	GPtrArray *source_files = g_ptr_array_new();
+	gsize bytes = 0;
+	gint64 start;
+	gint i;
+	guint j;
+
+	for (j = 0; j < files->len; j++)
+	{
+		BenchFile *file = files->pdata[j];
+
+		g_ptr_array_add(source_files,
+			tm_source_file_new(file->file_name, tm_source_file_get_lang_name(file->lang)));
+		bytes += file->length;
+	}
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < files->len; j++)
+		{
+			BenchFile *file = files->pdata[j];
+
+			tm_source_file_parse(source_files->pdata[j], (guchar *) file->contents,
+				file->length, TRUE);
+		}
+	}
+	print_result("parse", g_get_monotonic_time() - start,
+		(gdouble) bytes * iterations / (1024 * 1024), "MiB");
+
+	*tag_count = 0;
+	for (j = 0; j < source_files->len; j++)
+		*tag_count += TM_SOURCE_FILE(source_files->pdata[j])->tags_array->len;
+
+	return source_files;
+}
+
+
+/* Sorts the tags of each file and merges them one by one into a workspace-like
+ * array, as happens when opening files */
+static void bench_sort_merge(GPtrArray *source_files, guint tag_count)
+{
+	gint64 sort_time = 0, merge_time = 0;
+	gint i;
+	guint j;
+
+	for (i = 0; i < iterations; i++)
+	{
+		GPtrArray *merged = g_ptr_array_new();
+
+		for (j = 0; j < source_files->len; j++)
+		{
+			GPtrArray *tags = TM_SOURCE_FILE(source_files->pdata[j])->tags_array;
+			GPtrArray *copy = g_ptr_array_sized_new(tags->len);
+			GPtrArray *new_merged;
+			gint64 start;
+
+			/* sort a copy so every iteration gets the same unsorted input */
+			g_ptr_array_set_size(copy, tags->len);
+			memcpy(copy->pdata, tags->pdata, tags->len * sizeof(gpointer));
+
+			start = g_get_monotonic_time();
+			tm_tags_sort(copy, file_tags_sort_attrs, FALSE, FALSE);
+			sort_time += g_get_monotonic_time() - start;
+
+			start = g_get_monotonic_time();
+			new_merged = tm_tags_merge(merged, copy, workspace_tags_sort_attrs, FALSE);
+			merge_time += g_get_monotonic_time() - start;
+
+			g_ptr_array_free(merged, TRUE);
+			g_ptr_array_free(copy, TRUE);
+			merged = new_merged;
+		}
+		g_ptr_array_free(merged, TRUE);
+	}
+
+	print_result("sort", sort_time, (gdouble) tag_count * iterations, "tags");
+	print_result("merge", merge_time, (gdouble) tag_count * iterations, "tags");
+}
+
+
+/* Adds all files to the workspace from disk */
+static GPtrArray *bench_workspace_add(GPtrArray *files)
+{
+	GPtrArray *source_files = g_ptr_array_new();
+	gint64 start;
+	guint j;
+
+	for (j = 0; j < files->len; j++)
+	{
+		BenchFile *file = files->pdata[j];
+
+		g_ptr_array_add(source_files,
+			tm_source_file_new(file->file_name, tm_source_file_get_lang_name(file->lang)));
+	}
+
+	start = g_get_monotonic_time();
+	tm_workspace_add_source_files(source_files);
+	print_result("workspace add", g_get_monotonic_time() - start, source_files->len, "files");
+
+	return source_files;
+}
+
+
+/* Returns the first tag of each name in the (sorted) workspace tags */
+static GPtrArray *get_query_tags(void)
+{
+	const GPtrArray *tags = tm_get_workspace()->tags_array;
+	GPtrArray *queries = g_ptr_array_new();
+	TMTag *last = NULL;
+	guint i;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+
+		if (!last || strcmp(last->name, tag->name) != 0)
+			g_ptr_array_add(queries, tag);
+		last = tag;
+	}
+	return queries;
+}
+
+
+static void bench_find(GPtrArray *queries)
+{
+	guint results = 0;
+	gint64 start;
+	gint i;
+	guint j;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < queries->len; j++)
+		{
+			TMTag *tag = queries->pdata[j];
+			GPtrArray *tags = tm_workspace_find(tag->name, NULL, tm_tag_max_t, NULL, tag->lang);
+
+			results += tags->len;
+			g_ptr_array_free(tags, TRUE);
+		}
+	}
+	print_result("find", g_get_monotonic_time() - start,
+		(gdouble) queries->len * iterations, "queries");
+	printf("%-24s %10.1f\n", "  tags per query", queries->len ? (gdouble) results / (queries->len * iterations) : 0.0);
+}
+
+
+static void bench_find_prefix(GPtrArray *queries)
+{
+	guint results = 0;
+	gint64 start;
+	gint i;
+	guint j;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < queries->len; j++)
+		{
+			TMTag *tag = queries->pdata[j];
+			gchar *prefix = g_strndup(tag->name, PREFIX_LEN);
+			GPtrArray *tags = tm_workspace_find_prefix(prefix, tag->lang, PREFIX_MAX_NUM);
+
+			results += tags->len;
+			g_ptr_array_free(tags, TRUE);
+			g_free(prefix);
+		}
+	}
+	print_result("find prefix", g_get_monotonic_time() - start,
+		(gdouble) queries->len * iterations, "queries");
+	printf("%-24s %10.1f\n", "  tags per query", queries->len ? (gdouble) results / (queries->len * iterations) : 0.0);
+}
+
+
+/* Like bench_find_prefix(), but with the case-insensitive and initials matches
+ * autocompletion shows */
+static void bench_find_completions(GPtrArray *queries)
+{
+	guint results = 0;
+	gint64 start;
+	gint i;
+	guint j;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < queries->len; j++)
+		{
+			TMTag *tag = queries->pdata[j];
+			gchar *prefix = g_strndup(tag->name, PREFIX_LEN);
+			GPtrArray *tags = tm_workspace_find_completions(prefix, tag->lang, PREFIX_MAX_NUM);
+
+			results += tags->len;
+			g_ptr_array_free(tags, TRUE);
+			g_free(prefix);
+		}
+	}
+	print_result("find completions", g_get_monotonic_time() - start,
+		(gdouble) queries->len * iterations, "queries");
+	printf("%-24s %10.1f\n", "  tags per query", queries->len ? (gdouble) results / (queries->len * iterations) : 0.0);
+}
+
+
+/* Looks up the members of each type, like completion after "Type::" */
+static void bench_find_scope_members(GPtrArray *queries)
+{
+	guint query_count = 0, results = 0;
+	gint64 start;
+	gint i;
+	guint j;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < queries->len; j++)
+		{
+			TMTag *tag = queries->pdata[j];
+			GPtrArray *tags;
+
+			if (!(tag->type & TYPES_WITH_MEMBERS))
+				continue;
+
+			tags = tm_workspace_find_scope_members(tag->file, tag->name, FALSE, TRUE, NULL, TRUE);
+			if (tags)
+			{
+				results += tags->len;
+				g_ptr_array_free(tags, TRUE);
+			}
+			query_count++;
+		}
+	}
+	print_result("find scope members", g_get_monotonic_time() - start, query_count, "queries");
+	printf("%-24s %10.1f\n", "  tags per query", query_count ? (gdouble) results / query_count : 0.0);
+}
+
+
+/* Splits the contents of all files into lines, roughly the least work a parser
+ * has to do. Parser times are expressed relative to it so that baselines don't
+ * depend too much on the machine they were recorded on. Returns the best time of
+ * a single scan. */
+static gdouble time_line_scan(GPtrArray *files)
+{
+	gdouble best = G_MAXDOUBLE;
+	volatile gsize lines = 0;
+	guint reps = 1;
+	gint i;
+	guint j, r;
+
+	for (i = 0; i <= iterations; i++)
+	{
+		gint64 start = g_get_monotonic_time();
+		gint64 usecs;
+
+		for (r = 0; r < reps; r++)
+		{
+			for (j = 0; j < files->len; j++)
+			{
+				BenchFile *file = files->pdata[j];
+				const gchar *p = file->contents;
+				const gchar *end = p + file->length;
+
+				while ((p = memchr(p, '\n', end - p)) != NULL)
+				{
+					lines++;
+					p++;
+				}
+			}
+		}
+		usecs = g_get_monotonic_time() - start;
+		/* the first round only finds out how often to repeat the scan */
+		if (i == 0)
+			reps = MIN_TIMED_USECS / MAX(usecs, 1) + 1;
+		else
+			best = MIN(best, (gdouble) usecs / reps);
+	}
+	return MAX(best, 0.001);
+}
+
+
+/* Parses the files of lang once, returns how long it took */
+static gint64 parse_lang_files(GPtrArray *files, GPtrArray *source_files, TMParserType lang)
+{
+	gint64 start = g_get_monotonic_time();
+	guint j, k = 0;
+
+	for (j = 0; j < files->len; j++)
+	{
+		BenchFile *file = files->pdata[j];
+
+		if (file->lang != lang)
+			continue;
+		tm_source_file_parse(source_files->pdata[k++], (guchar *) file->contents,
+			file->length, TRUE);
+	}
+	return g_get_monotonic_time() - start;
+}
+
+
+/* Parses the files of each language separately. The allocations of a parse
+ * are counted after a first parse, so that lazy initialization isn't included.
+ * Unless only allocations are wanted, the files are then parsed repeatedly to
+ * take at least MIN_TIMED_USECS and the best time over all iterations is kept. */
+static GPtrArray *bench_parsers(GPtrArray *files)
+{
+	GPtrArray *results = g_ptr_array_new_with_free_func(g_free);
+	guint lang, j;
+	gint i;
+
+	for (lang = 0; lang < tm_ctags_get_lang_count(); lang++)
+	{
+		ParserResult *result = g_new0(ParserResult, 1);
+		GPtrArray *source_files = g_ptr_array_new();
+		gulong allocations;
+		gint64 usecs;
+		guint reps, r;
+
+		result->lang = lang;
+		for (j = 0; j < files->len; j++)
+		{
+			BenchFile *file = files->pdata[j];
+
+			if (file->lang != (TMParserType) lang)
+				continue;
+			g_ptr_array_add(source_files,
+				tm_source_file_new(file->file_name, tm_source_file_get_lang_name(file->lang)));
+			result->bytes += file->length;
+		}
+		if (source_files->len == 0)
+		{
+			g_ptr_array_free(source_files, TRUE);
+			g_free(result);
+			continue;
+		}
+
+		usecs = parse_lang_files(files, source_files, lang);
+
+		allocations = tm_ctags_get_allocation_count();
+		parse_lang_files(files, source_files, lang);
+		result->allocations = tm_ctags_get_allocation_count() - allocations;
+
+		if (!allocations_only)
+		{
+			reps = MIN_TIMED_USECS / MAX(usecs, 1) + 1;
+			result->usecs = G_MAXDOUBLE;
+			for (i = 0; i < iterations; i++)
+			{
+				usecs = 0;
+				for (r = 0; r < reps; r++)
+					usecs += parse_lang_files(files, source_files, lang);
+				result->usecs = MIN(result->usecs, (gdouble) usecs / reps);
+			}
+			result->usecs = MAX(result->usecs, 0.001);
+		}
+
+		for (j = 0; j < source_files->len; j++)
+		{
+			result->tags += TM_SOURCE_FILE(source_files->pdata[j])->tags_array->len;
+			tm_source_file_free(source_files->pdata[j]);
+		}
+		g_ptr_array_free(source_files, TRUE);
+		g_ptr_array_add(results, result);
+	}
+	return results;
+}
+
+
+/* The parse time of result relative to the line scan time of the same amount of input */
+static gdouble get_parser_cost(ParserResult *result, gdouble scan_usecs_per_byte)
+{
+	return result->usecs / result->bytes / scan_usecs_per_byte;
+}
+
+
+/* Reads a baseline file made of "LANGUAGE COST ALLOCATIONS" lines, where COST is
+ * the parse time relative to the line scan time for the same input, or "-" if
+ * unknown, and ALLOCATIONS the number of ctags allocations of one parse */
+static GHashTable *read_baseline(const gchar *file_name)
+{
+	GHashTable *baseline = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	gchar *contents;
+	gchar **lines;
+	guint i;
+
+	if (!g_file_get_contents(file_name, &contents, NULL, NULL))
+	{
+		fprintf(stderr, "Failed to read baseline file %s\n", file_name);
+		return baseline;
+	}
+
+	lines = g_strsplit(contents, "\n", -1);
+	for (i = 0; lines[i]; i++)
+	{
+		gchar *line = g_strstrip(lines[i]);
+		gchar *alloc_space = strrchr(line, ' ');
+		gchar *cost_space;
+		BaselineEntry *entry;
+
+		if (line[0] == '#' || !alloc_space)
+			continue;
+		*alloc_space = '\0';
+		cost_space = strrchr(line, ' ');
+		if (!cost_space)
+			continue;
+		*cost_space = '\0';
+		entry = g_new(BaselineEntry, 1);
+		entry->cost = g_ascii_strtod(cost_space + 1, NULL);
+		entry->allocations = g_ascii_strtoull(alloc_space + 1, NULL, 10);
+		g_hash_table_insert(baseline, g_strdup(g_strstrip(line)), entry);
+	}
+	g_strfreev(lines);
+	g_free(contents);
+
+	return baseline;
+}
+
+
+static gboolean write_baseline(const gchar *file_name, GPtrArray *results,
+		gdouble scan_usecs_per_byte)
+{
+	GString *str = g_string_new(
+		"# Parser baseline, see tests/bench/tm_bench.c.\n"
+		"# Each line gives a parser, its parse time relative to a plain line scan\n"
+		"# of the same input and the number of ctags allocations of one parse of\n"
+		"# tests/ctags. Regenerate with \"make bench-baseline\".\n");
+	gboolean success;
+	guint i;
+
+	for (i = 0; i < results->len; i++)
+	{
+		ParserResult *result = results->pdata[i];
+		gchar cost[G_ASCII_DTOSTR_BUF_SIZE] = "-";
+
+		if (!allocations_only)
+			g_ascii_formatd(cost, sizeof(cost), "%.2f", get_parser_cost(result, scan_usecs_per_byte));
+		g_string_append_printf(str, "%s %s %lu\n", tm_source_file_get_lang_name(result->lang),
+			cost, result->allocations);
+	}
+	success = g_file_set_contents(file_name, str->str, str->len, NULL);
+	if (!success)
+		fprintf(stderr, "Failed to write baseline file %s\n", file_name);
+	g_string_free(str, TRUE);
+
+	return success;
+}
+
+
+/* Prints the throughput and allocations of each parser and returns FALSE if
+ * one of them got slower or allocates more than the baseline allows */
+static gboolean report_parsers(GPtrArray *files)
+{
+	GHashTable *baseline = baseline_file ? read_baseline(baseline_file) : NULL;
+	gdouble scan_usecs_per_byte = 0;
+	GPtrArray *results;
+	gboolean success = TRUE;
+	gsize bytes = 0;
+	guint i;
+
+	if (!allocations_only)
+	{
+		for (i = 0; i < files->len; i++)
+			bytes += ((BenchFile *) files->pdata[i])->length;
+		scan_usecs_per_byte = time_line_scan(files) / MAX(bytes, 1);
+	}
+	results = bench_parsers(files);
+
+	printf("%-16s %10s %10s %12s", "parser", "KiB", "tags", "allocations");
+	if (!allocations_only)
+		printf(" %12s %10s", "MiB/s", "cost");
+	printf("\n");
+	for (i = 0; i < results->len; i++)
+	{
+		ParserResult *result = results->pdata[i];
+		const gchar *name = tm_source_file_get_lang_name(result->lang);
+		BaselineEntry *expected = baseline ? g_hash_table_lookup(baseline, name) : NULL;
+		gdouble cost = 0;
+
+		printf("%-16s %10lu %10u %12lu", name, (gulong) result->bytes / 1024,
+			result->tags, result->allocations);
+		if (!allocations_only)
+		{
+			cost = get_parser_cost(result, scan_usecs_per_byte);
+			printf(" %12.2f %10.2f",
+				result->bytes / (1024.0 * 1024.0) / (result->usecs / G_USEC_PER_SEC), cost);
+		}
+		if (expected)
+		{
+			gboolean regressed = result->allocations >
+				expected->allocations * (100 + alloc_tolerance) / 100.0;
+
+			printf("  (baseline %lu", expected->allocations);
+			if (!allocations_only && expected->cost > 0)
+			{
+				printf(", %.2f", expected->cost);
+				if (cost > expected->cost * (100 + tolerance) / 100.0)
+					regressed = TRUE;
+			}
+			printf(")%s", regressed ? " REGRESSION" : "");
+			if (regressed)
+				success = FALSE;
+		}
+		else if (baseline)
+			printf("  (not in baseline)");
+		printf("\n");
+	}
+
+	if (new_baseline_file && !write_baseline(new_baseline_file, results, scan_usecs_per_byte))
+		success = FALSE;
+
+	g_ptr_array_free(results, TRUE);
+	if (baseline)
+		g_hash_table_destroy(baseline);
+
+	return success;
+}
+
+
+static void free_bench_file(gpointer data)
+{
+	BenchFile *file = data;
+
+	g_free(file->file_name);
+	g_free(file->contents);
+	g_free(file);
+}
+
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GPtrArray *files, *parsed_files, *workspace_files, *queries;
+	gsize bytes = 0;
+	guint tag_count, i;
+	gint j;
+
+	context = g_option_context_new("DIRECTORY|FILE... - benchmark the tag manager");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+	if (argc < 2 || iterations < 1 || scale < 1 || tolerance < 0 || alloc_tolerance < 0)
+	{
+		fprintf(stderr, "Usage: %s [-n N] [-s N] [-g FILE [-l NAME]] DIRECTORY|FILE...\n"
+			"       %s -p [-a] [-n N] [-s N] [-b FILE] [-t PERCENT] [-A PERCENT] [-w FILE] DIRECTORY|FILE...\n",
+			argv[0], argv[0]);
+		return 1;
+	}
+
+	/* initializes ctags */
+	tm_get_workspace();
+
+	files = g_ptr_array_new_with_free_func(free_bench_file);
+	for (j = 1; j < argc; j++)
+		collect_files(argv[j], files);
+	for (i = 0; i < files->len; i++)
+		bytes += ((BenchFile *) files->pdata[i])->length;
+	printf("%u files, %lu bytes, %d iterations\n\n", files->len, (gulong) bytes, iterations);
+
+	if (parsers_only)
+	{
+		gboolean success = report_parsers(files);
+
+		g_ptr_array_free(files, TRUE);
+		tm_workspace_free();
+		g_free(baseline_file);
+		g_free(new_baseline_file);
+		return success ? 0 : 1;
+	}
+
+	parsed_files = bench_parse(files, &tag_count);
+	printf("%-24s %10u\n", "  tags", tag_count);
+	bench_sort_merge(parsed_files, tag_count);
+	for (i = 0; i < parsed_files->len; i++)
+		tm_source_file_free(parsed_files->pdata[i]);
+	g_ptr_array_free(parsed_files, TRUE);
+
+	workspace_files = bench_workspace_add(files);
+	if (global_tags_file)
+	{
+		TMParserType lang = tm_source_file_get_named_lang(global_tags_lang ? global_tags_lang : "C");
+		gint64 start = g_get_monotonic_time();
+
+		if (!tm_workspace_load_global_tags(global_tags_file, lang))
+			fprintf(stderr, "Failed to load global tags file %s\n", global_tags_file);
+		print_result("load global tags", g_get_monotonic_time() - start,
+			tm_get_workspace()->global_tags->len, "tags");
+	}
+
+	queries = get_query_tags();
+	bench_find(queries);
+	bench_find_prefix(queries);
+	bench_find_completions(queries);
+	bench_find_scope_members(queries);
+	g_ptr_array_free(queries, TRUE);
+
+	printf("\n");
+	print_peak_memory();
+
+	tm_workspace_remove_source_files(workspace_files);
+	for (i = 0; i < workspace_files->len; i++)
+		tm_source_file_free(workspace_files->pdata[i]);
+	g_ptr_array_free(workspace_files, TRUE);
+	g_ptr_array_free(files, TRUE);
+	tm_workspace_free();
+	g_free(global_tags_file);
+	g_free(global_tags_lang);
+
+	return 0;
+}